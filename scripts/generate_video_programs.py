@@ -0,0 +1,228 @@
+"""
+Expands the BIOS video mode tables in src/application/xbox_video_bios.h into
+pre-packed ADV7511 register programs (src/application/xbox_video_programs.h).
+
+Runs as a PlatformIO pre script for the application, or by hand:
+    python scripts/generate_video_programs.py
+The output is committed so timing table changes show up as a reviewable diff.
+"""
+
+import os
+import re
+import sys
+
+ENCODERS = [
+    ("CONEXANT", "ENCODER_CONEXANT"),
+    ("FOCUS", "ENCODER_FOCUS"),
+    ("XCALIBUR", "ENCODER_XCALIBUR"),
+]
+
+# Only this mode is ever sent interlaced (see set_video_mode_bios)
+INTERLACED_MODE_INDEX = 0x0E
+
+FIELDS = [
+    "hs_delay", "vs_delay", "h_active", "v_active",
+    "hsync_placement", "hsync_duration", "vsync_placement", "vsync_duration",
+    "interlaced_offset",
+]
+
+VIC_NAMES = {
+    0: "VIC_00_VIC_Unavailable",
+    2: "VIC_02_480p_60__4_3",
+    3: "VIC_03_480p_60_16_9",
+    4: "VIC_04_720p_60_16_9",
+    5: "VIC_05_1080i_60_16_9",
+    17: "VIC_17_576p_50__4_3",
+    18: "VIC_18_576p_50_16_9",
+}
+
+
+def parse_tables(header):
+    tables = {}
+    for name, body in re.findall(r"static const VideoMode (\w+)_TABLE\[\] = \{(.*?)\n\};", header, re.S):
+        entries = []
+        for values, comment in re.findall(r"\{([^}]*)\},?\s*//\s*([^\n]*)", body):
+            numbers = [int(v.strip(), 0) for v in values.split(",")]
+            if len(numbers) != len(FIELDS):
+                raise ValueError(f"{name}: unexpected entry {{{values}}}")
+            entry = dict(zip(FIELDS, numbers))
+            entry["comment"] = " ".join(comment.split())
+            entries.append(entry)
+        tables[name] = entries
+    return tables
+
+
+def vic_for(vm, widescreen):
+    # VIC for the active area, 480 line modes keep the mapping the firmware shipped with
+    if vm["h_active"] in (640, 720):
+        if vm["v_active"] == 576:
+            return 18 if widescreen else 17
+        return 2 if widescreen else 3
+    if vm["h_active"] == 1280:
+        return 4
+    if vm["h_active"] == 1920:
+        return 5
+    return 0
+
+
+def u8(value):
+    return value & 0xFF
+
+
+def mode_program(vm):
+    """Timing, sync adjustment and VIC for one table entry, as source lines."""
+    hs, vs = vm["hs_delay"], vm["vs_delay"]
+    ha, va = vm["h_active"], vm["v_active"]
+    hp, hd = vm["hsync_placement"], vm["hsync_duration"]
+    vp, vd = vm["vsync_placement"], vm["vsync_duration"]
+
+    de = [u8(hs >> 2), (vs & 0x3F) | u8(hs << 6) & 0xC0]
+    active = [u8(ha << 1), u8(va >> 4), u8(va << 4)]
+    sync = [
+        u8(hp >> 2),
+        u8(u8(hp << 6) | (hd >> 4)),
+        u8(u8(hd << 4) | (vp >> 6)),
+        u8(u8(vp << 2) | (vd >> 8)),
+        u8(vd),
+        u8(vm["interlaced_offset"] << 5),
+    ]
+
+    def hexes(values):
+        return ", ".join(f"0x{v:02X}" for v in values)
+
+    lines = [
+        f"ADV7511_OP_WRITE, 0x35, {len(de)}, {hexes(de)},",
+        f"ADV7511_OP_UPDATE, 0x37, 0x1F, 0x{(ha >> 7) & 0x1F:02X}, // 0x37 is shared with interlaced",
+        f"ADV7511_OP_WRITE, 0x38, {len(active)}, {hexes(active)},",
+        f"ADV7511_OP_WRITE, 0xD7, {len(sync)}, {hexes(sync)},",
+        "ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings",
+        "ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i",
+        f"ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, {VIC_NAMES[vic_for(vm, False)]},",
+        f"ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, {VIC_NAMES[vic_for(vm, True)]},",
+        "ADV7511_OP_END,",
+    ]
+    return lines
+
+
+def program_size(lines):
+    size = 0
+    for line in lines:
+        code = line.split("//")[0]
+        size += len([t for t in code.split(",") if t.strip()])
+    return size
+
+
+def generate(tables):
+    out = []
+    out.append("// Generated by scripts/generate_video_programs.py from xbox_video_bios.h, do not edit")
+    out.append("")
+    out.append("#ifndef __XBOX_VIDEO_PROGRAMS_H__")
+    out.append("#define __XBOX_VIDEO_PROGRAMS_H__")
+    out.append("")
+    out.append('#include "../shared/adv7511_vic.h"')
+    out.append('#include "adv7511_program.h"')
+    out.append("")
+    out.append("#define BIOS_MODE_COUNT 18")
+    out.append("")
+    out.append("// Runs before every mode program")
+    out.append("static const uint8_t BIOS_PROGRAM_PROLOGUE[] = {")
+    out.append("    ADV7511_OP_WRITE, 0x3B, 1, 0b01100000, // Force pixel repeat to 1 (for forcing VIC)")
+    out.append("    ADV7511_OP_UPDATE | ADV7511_OP_IF_RGB, 0x18, 0b10000000, 0b10000000, // Convert RGB to YCbCr")
+    out.append("    ADV7511_OP_UPDATE | ADV7511_OP_IF_YCBCR, 0x18, 0b10000000, 0b00000000,")
+    out.append("    ADV7511_OP_END")
+    out.append("};")
+    out.append("")
+    out.append("// Runs after every mode program, AVI infoframe aspect ratio")
+    out.append("static const uint8_t BIOS_PROGRAM_EPILOGUE[] = {")
+    out.append("    ADV7511_OP_UPDATE, 0x4A, 0b01000000, 0b01000000, // Start AVI Infoframe Update")
+    out.append("    ADV7511_OP_UPDATE, 0x55, 0b01100000, 0b01000000, // YCbCr 4:4:4")
+    out.append("    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x56, 1, 0b00011000, // 4:3")
+    out.append("    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x56, 1, 0b00101000, // 16:9")
+    out.append("    ADV7511_OP_UPDATE, 0x4A, 0b01000000, 0b00000000, // End AVI Infoframe Update")
+    out.append("    ADV7511_OP_END")
+    out.append("};")
+    out.append("")
+
+    # One pool so identical programs are only stored once and tables hold offsets
+    pool = []       # [labels, lines]
+    pool_index = {} # program bytes -> pool entry
+    offsets = {}
+    for name, _ in ENCODERS:
+        if name not in tables:
+            raise ValueError(f"{name}_TABLE not found")
+        if len(tables[name]) != 18:
+            raise ValueError(f"{name}_TABLE must have 18 entries")
+        for index, vm in enumerate(tables[name], start=1):
+            variants = [("progressive", vm)]
+            if index == INTERLACED_MODE_INDEX:
+                half = dict(vm)
+                half["v_active"] //= 2
+                half["vs_delay"] //= 2
+                variants.append(("interlaced", half))
+            for variant, timing in variants:
+                lines = mode_program(timing)
+                key = tuple(l.split("//")[0] for l in lines)
+                label = f"{name} {vm['comment']}" + ("" if variant == "progressive" else " (interlaced)")
+                if key not in pool_index:
+                    pool_index[key] = (sum(program_size(p[1]) for p in pool), len(pool))
+                    pool.append([[label], lines])
+                else:
+                    pool[pool_index[key][1]][0].append(label)
+                offsets[(name, index, variant)] = pool_index[key][0]
+
+    total = sum(program_size(p[1]) for p in pool)
+    if total > 0xFFFF:
+        raise ValueError("program pool too large for 16 bit offsets")
+
+    out.append(f"// {len(pool)} unique programs, {total} bytes")
+    out.append("static const uint8_t BIOS_PROGRAM_POOL[] = {")
+    offset = 0
+    for labels, lines in pool:
+        out.append(f"    // @{offset}: " + "; ".join(labels))
+        for line in lines:
+            out.append("    " + line)
+        offset += program_size(lines)
+    out.append("};")
+    out.append("")
+    out.append("typedef struct {")
+    out.append("    uint16_t progressive;  // Offsets into BIOS_PROGRAM_POOL")
+    out.append("    uint16_t interlaced;")
+    out.append("} bios_mode_program;")
+    out.append("")
+    for name, _ in ENCODERS:
+        out.append(f"static const bios_mode_program {name}_PROGRAMS[BIOS_MODE_COUNT] = {{")
+        for index in range(1, 19):
+            progressive = offsets[(name, index, "progressive")]
+            interlaced = offsets.get((name, index, "interlaced"), progressive)
+            out.append(f"    {{{progressive:4d}, {interlaced:4d}}}, // {index:02X}")
+        out.append("};")
+        out.append("")
+    out.append("#endif // __XBOX_VIDEO_PROGRAMS_H__")
+    out.append("")
+    return "\n".join(out)
+
+
+def run(project_dir):
+    source = os.path.join(project_dir, "src", "application", "xbox_video_bios.h")
+    target = os.path.join(project_dir, "src", "application", "xbox_video_programs.h")
+
+    with open(source, "r") as f:
+        text = generate(parse_tables(f.read()))
+
+    current = None
+    if os.path.exists(target):
+        with open(target, "r") as f:
+            current = f.read()
+
+    # Only touch the file when it changes to avoid needless rebuilds
+    if current != text:
+        with open(target, "w", newline="\n") as f:
+            f.write(text)
+        print(f"Generated {os.path.relpath(target, project_dir)}")
+
+
+try:
+    Import("env")
+    run(env["PROJECT_DIR"])
+except NameError:
+    run(os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
@@ -3,28 +3,52 @@
 
 #include "../shared/adv7511_minimal.h"
 #include "../shared/adv7511_i2c.h"
+#include "../shared/adv7511_regs.h"
 #include "adv7511.h"
 
+// Received frame buffer and its length, written by the CEC engine
+static const uint8_t cec_map_volatile[ADV7511_CEC_MAP_SIZE / 8] = {
+    [0x15 / 8] = 0b11100000,
+    [0x18 / 8] = 0xFF,
+    [0x20 / 8] = 0b01111111,
+};
+
+static uint8_t cec_map_known[ADV7511_CEC_MAP_SIZE / 8];
+static uint8_t cec_map_value[ADV7511_CEC_MAP_SIZE];
+
+static adv7511_regmap cec_map = {
+    .i2c_addr = ADV7511_CEC_I2C_ADDR_DEFAULT,
+    .size = ADV7511_CEC_MAP_SIZE,
+    .volatile_regs = cec_map_volatile,
+    .known = cec_map_known,
+    .value = cec_map_value,
+};
+
+uint8_t adv7511_read_cec(const uint8_t address) {
+    return adv7511_map_read(&cec_map, address);
+}
+
 void adv7511_write_cec(const uint8_t address, uint8_t value) {
-    I2C_HandleTypeDef* hi2c = adv7511_i2c_instance();
-    HAL_I2C_Mem_Write(hi2c, ADV7511_CEC_I2C_ADDR_DEFAULT, address, I2C_MEMADD_SIZE_8BIT, &value, 1, HAL_MAX_DELAY);
+    adv7511_map_write(&cec_map, address, value);
+}
+
+void adv7511_update_cec(const uint8_t address, const uint8_t mask, uint8_t new_value) {
+    adv7511_map_update(&cec_map, address, mask, new_value);
 }
 
 void adv7511_apply_csc(const uint8_t * const coefficients) {
     // Write CSC coefficients to registers 0x18-0x2F
-    for (uint8_t i = 0; i < 24; i++) {
-        adv7511_write_register(0x18 + i, coefficients[i]);
-    }
+    adv7511_write_registers(0x18, coefficients, 24);
 }
 
 inline void adv7511_disable_video() {
     // [0] Gate ouput
-    adv7511_update_register(0xD6, 0b00000001, 0b00000001);
+    adv7511_set_video_gate(1);
 }
 
 inline void adv7511_enable_video() {
     // [1] Enable ouput
-    adv7511_update_register(0xD6, 0b00000001, 0b00000000);
+    adv7511_set_video_gate(0);
 }
 
 inline void adv7511_power_down_tmds() {
@@ -32,7 +56,7 @@ inline void adv7511_power_down_tmds() {
     // [4] Channel 1 power down
     // [3] Channel 2 power down
     // [2] Clock Driver power down
-    adv7511_update_register(0xA1, 0b00111100, 0b00111100);
+    adv7511_set_tmds_power_down(0b1111);
 }
 
 inline void adv7511_power_up_tmds() {
@@ -40,5 +64,5 @@ inline void adv7511_power_up_tmds() {
     // [4] Channel 1 power up
     // [3] Channel 2 power up
     // [2] Clock Driver power up
-    adv7511_update_register(0xA1, 0b00111100, 0b00000000);
+    adv7511_set_tmds_power_down(0b0000);
 }
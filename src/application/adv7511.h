@@ -9,6 +9,9 @@
 #define ADV7511_EDID_I2C_ADDR_DEFAULT   0x7E //0x7E>>1
 #define ADV7511_PACKET_I2C_ADDR_DEFAULT 0x70 //0x70>>1
 
+// Only the lower half of the CEC map is populated, don't shadow the rest
+#define ADV7511_CEC_MAP_SIZE            0x80
+
 enum adv7511_sync_polarity
 {
     ADV7511_SYNC_POLARITY_PASSTHROUGH,
@@ -151,7 +154,9 @@ static const uint8_t CscYcc601LRtoYcc709FR[] = {
     0x1E, 0x0E, 0x09, 0x5A, 0x1E, 0xEC, 0x00, 0xED,
     0x01, 0x0B, 0x00, 0x00, 0x09, 0x46, 0x1E, 0xD7};
 
+uint8_t adv7511_read_cec(const uint8_t address);
 void adv7511_write_cec(const uint8_t address, uint8_t value);
+void adv7511_update_cec(const uint8_t address, const uint8_t mask, uint8_t new_value);
 
 void adv7511_apply_csc(const uint8_t * const coefficients);
 
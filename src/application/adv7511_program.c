@@ -0,0 +1,74 @@
+#include "../shared/adv7511_minimal.h"
+#include "../shared/adv7511_i2c.h"
+#include "adv7511_program.h"
+
+// Consecutive registers are collected and sent as one burst, capped so the
+// queue copies the run and it can live on the stack
+typedef struct {
+    uint8_t start;
+    uint8_t length;
+    uint8_t data[ADV7511_I2C_INLINE_SIZE];
+} register_run;
+
+static void run_flush(register_run *run) {
+    if (run->length) {
+        adv7511_write_registers(run->start, run->data, run->length);
+        run->length = 0;
+    }
+}
+
+static void run_append(register_run *run, const uint8_t reg, const uint8_t mask, const uint8_t value) {
+    if (run->length && (reg != (uint8_t)(run->start + run->length) || run->length == sizeof(run->data))) {
+        run_flush(run);
+    }
+
+    if (run->length == 0) {
+        run->start = reg;
+    }
+
+    // Masked updates resolve against the register shadow, normally without touching the bus
+    run->data[run->length++] = (mask == 0xFF) ? value : (adv7511_read_register(reg) & ~mask) | (value & mask);
+}
+
+static bool op_enabled(const uint8_t op, const uint8_t flags, const uint8_t conditions) {
+    if (conditions != ADV7511_OP_ALL && !(op & conditions)) return false;
+
+    const bool wide = flags & ADV7511_PROGRAM_WIDESCREEN;
+    const bool rgb = flags & ADV7511_PROGRAM_RGB;
+
+    if ((op & ADV7511_OP_IF_WIDE) && !wide) return false;
+    if ((op & ADV7511_OP_IF_NARROW) && wide) return false;
+    if ((op & ADV7511_OP_IF_RGB) && !rgb) return false;
+    if ((op & ADV7511_OP_IF_YCBCR) && rgb) return false;
+    return true;
+}
+
+void adv7511_run_program(const uint8_t *program, const uint8_t flags) {
+    adv7511_run_program_only(program, flags, ADV7511_OP_ALL);
+}
+
+void adv7511_run_program_only(const uint8_t *program, const uint8_t flags, const uint8_t conditions) {
+    register_run run = {0};
+
+    while ((*program & ADV7511_OP_MASK) != ADV7511_OP_END) {
+        const uint8_t op = *program++;
+        const uint8_t reg = *program++;
+        const bool enabled = op_enabled(op, flags, conditions);
+
+        if ((op & ADV7511_OP_MASK) == ADV7511_OP_WRITE) {
+            const uint8_t count = *program++;
+            for (uint8_t i = 0; enabled && i < count; i++) {
+                run_append(&run, reg + i, 0xFF, program[i]);
+            }
+            program += count;
+        } else {
+            const uint8_t mask = *program++;
+            const uint8_t value = *program++;
+            if (enabled) {
+                run_append(&run, reg, mask, value);
+            }
+        }
+    }
+
+    run_flush(&run);
+}
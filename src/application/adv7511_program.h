@@ -0,0 +1,34 @@
+#ifndef __ADV7511_PROGRAM_H__
+#define __ADV7511_PROGRAM_H__
+
+#include <stdint.h>
+
+// Pre-packed ADV7511 main map register programs, see scripts/generate_video_programs.py
+//
+// Every op starts with an opcode byte, the high nibble holds conditions:
+//   ADV7511_OP_WRITE,  reg, count, value[count]   Plain writes of count registers from reg
+//   ADV7511_OP_UPDATE, reg, mask, value            Masked update of reg
+//   ADV7511_OP_END                                 End of program
+
+#define ADV7511_OP_END          0x00
+#define ADV7511_OP_WRITE        0x01
+#define ADV7511_OP_UPDATE       0x02
+#define ADV7511_OP_MASK         0x0F
+
+#define ADV7511_OP_IF_WIDE      0x10 // Only when ADV7511_PROGRAM_WIDESCREEN is set
+#define ADV7511_OP_IF_NARROW    0x20 // Only when ADV7511_PROGRAM_WIDESCREEN is clear
+#define ADV7511_OP_IF_RGB       0x40 // Only when ADV7511_PROGRAM_RGB is set
+#define ADV7511_OP_IF_YCBCR     0x80 // Only when ADV7511_PROGRAM_RGB is clear
+
+// Variant flags passed to adv7511_run_program
+#define ADV7511_PROGRAM_WIDESCREEN  0x01
+#define ADV7511_PROGRAM_RGB         0x02
+
+// Pass ADV7511_OP_ALL to run every op, or a set of ADV7511_OP_IF_* bits to only
+// run the conditional ops that depend on them
+#define ADV7511_OP_ALL          0x00
+
+void adv7511_run_program(const uint8_t *program, const uint8_t flags);
+void adv7511_run_program_only(const uint8_t *program, const uint8_t flags, const uint8_t conditions);
+
+#endif // __ADV7511_PROGRAM_H__
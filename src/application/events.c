@@ -0,0 +1,31 @@
+#include "events.h"
+#include "stm32f0xx_hal.h"
+#include "../shared/idle.h"
+
+static volatile uint32_t pending = 0;
+
+void event_post(const uint32_t events) {
+    // Cortex-M0 has no exclusive access, so the read-modify-write is done with interrupts masked
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    pending |= events;
+    __set_PRIMASK(primask);
+}
+
+uint32_t event_take() {
+    __disable_irq();
+    const uint32_t events = pending;
+    pending = 0;
+    __enable_irq();
+    return events;
+}
+
+void event_wait(const uint32_t timeout_ms) {
+    // WFI still wakes on an interrupt that became pending while masked, so an event posted
+    // between the check and the WFI isn't slept through
+    __disable_irq();
+    if (!pending && timeout_ms > 0) {
+        idle_sleep(timeout_ms);
+    }
+    __enable_irq();
+}
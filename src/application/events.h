@@ -0,0 +1,21 @@
+#ifndef __EVENTS_H__
+#define __EVENTS_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Work for the main loop, posted from interrupts and taken all at once by the loop
+#define EVENT_ADV_IRQ   (1U << 0)  // ADV7511 interrupt pin changed
+#define EVENT_SMBUS     (1U << 1)  // New video settings from the Xbox
+#define EVENT_POLL      (1U << 2)  // Periodic status poll, catches anything without an interrupt
+
+// Status registers are re-read at most this often when nothing else happens
+#define EVENT_POLL_INTERVAL_MS 100
+
+void event_post(const uint32_t events);
+uint32_t event_take();
+
+// Sleeps until the next interrupt or for at most timeout_ms, unless events are already pending
+void event_wait(const uint32_t timeout_ms);
+
+#endif // __EVENTS_H__
@@ -1,6 +1,8 @@
 #include "stm32f0xx_hal.h"
 #include "../shared/adv7511_minimal.h"
 #include "../shared/debug.h"
+#include "../shared/gpio.h"
+#include "events.h"
 
 void SysTick_Handler(void) {
     HAL_IncTick();
@@ -16,5 +18,6 @@ extern adv7511 encoder;
 
 void ADV_IRQ_HANDLER(void) {
     encoder.interrupt = 1;
-    HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_7);
+    event_post(EVENT_ADV_IRQ);
+    HAL_GPIO_EXTI_IRQHandler(ADV_IRQ_PIN);
 }
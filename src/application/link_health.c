@@ -0,0 +1,120 @@
+#include "link_health.h"
+#include "stm32f0xx_hal.h"
+#include "../shared/debug.h"
+
+typedef enum {
+    LINK_LOCKED,
+    LINK_UNLOCKED,      // Debouncing
+    LINK_RECOVERING,
+    LINK_FAILED         // Ladder exhausted, waiting to retry
+} link_state;
+
+static struct {
+    link_state state;
+    link_action action;
+    uint32_t unlocked_since;
+    uint32_t step_since;
+    bool tmds_held;
+    uint32_t tmds_since;
+} link = { LINK_LOCKED, LINK_ACTION_NONE, 0, 0, false, 0 };
+
+static link_health_stats stats;
+
+static inline void count(uint16_t *counter) {
+    if (*counter != UINT16_MAX) {
+        (*counter)++;
+    }
+}
+
+static link_action link_step(const link_action action, const uint32_t now) {
+    link.state = LINK_RECOVERING;
+    link.action = action;
+    link.step_since = now;
+    if (action == LINK_ACTION_TOGGLE_TMDS) {
+        link.tmds_held = true;
+        link.tmds_since = now;
+    }
+    debug_ring_log("Link: recovery step %d\r\n", action);
+    return action;
+}
+
+link_action link_health_update(const bool active, const bool pll_locked) {
+    const uint32_t now = HAL_GetTick();
+
+    if (!active) {
+        // A reinit takes the encoder down for a while, that is part of the step
+        if (link.state == LINK_RECOVERING) {
+            link.step_since = now;
+        } else {
+            link.state = LINK_LOCKED;
+        }
+        return LINK_ACTION_NONE;
+    }
+
+    if (pll_locked) {
+        if (link.state == LINK_RECOVERING || link.state == LINK_FAILED) {
+            const uint32_t relock_ms = now - link.unlocked_since;
+            stats.last_relock_ms = relock_ms > UINT16_MAX ? UINT16_MAX : (uint16_t)relock_ms;
+            stats.last_action = link.state == LINK_RECOVERING ? link.action : LINK_ACTION_NONE;
+            count(&stats.recovered[stats.last_action]);
+            debug_ring_log("Link: locked again after %ums, step %d\r\n", (unsigned int)relock_ms, stats.last_action);
+        }
+        link.state = LINK_LOCKED;
+        return LINK_ACTION_NONE;
+    }
+
+    switch (link.state) {
+        case LINK_LOCKED:
+            link.state = LINK_UNLOCKED;
+            link.unlocked_since = now;
+            return LINK_ACTION_NONE;
+
+        case LINK_UNLOCKED:
+            if ((now - link.unlocked_since) < LINK_UNLOCK_DEBOUNCE_MS) {
+                return LINK_ACTION_NONE;
+            }
+            count(&stats.unlocks);
+            return link_step(LINK_ACTION_RECOMMIT, now);
+
+        case LINK_RECOVERING:
+            if ((now - link.step_since) < LINK_STEP_TIMEOUT_MS) {
+                return LINK_ACTION_NONE;
+            }
+            if (link.action + 1 < LINK_ACTION_COUNT) {
+                return link_step((link_action)(link.action + 1), now);
+            }
+            count(&stats.failures);
+            link.state = LINK_FAILED;
+            link.step_since = now;
+            debug_ring_log("Link: recovery failed\r\n");
+            return LINK_ACTION_NONE;
+
+        default:
+            if ((now - link.step_since) < LINK_RETRY_MS) {
+                return LINK_ACTION_NONE;
+            }
+            return link_step(LINK_ACTION_RECOMMIT, now);
+    }
+}
+
+void link_health_reset() {
+    link.state = LINK_LOCKED;
+    link.action = LINK_ACTION_NONE;
+}
+
+// Not cleared by link_health_reset(), TMDS left off would be replayed at the next power up
+bool link_health_tmds_release() {
+    if (!link.tmds_held || (HAL_GetTick() - link.tmds_since) < LINK_TMDS_HOLD_MS) {
+        return false;
+    }
+    link.tmds_held = false;
+    return true;
+}
+
+bool link_health_tmds_held() {
+    return link.tmds_held;
+}
+
+const link_health_stats *link_health_get_stats() {
+    return &stats;
+}
@@ -0,0 +1,42 @@
+#ifndef __LINK_HEALTH_H__
+#define __LINK_HEALTH_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// PLL unlocked for this long before it counts as a lost link
+#define LINK_UNLOCK_DEBOUNCE_MS 300
+// How long each recovery step gets to bring the lock back
+#define LINK_STEP_TIMEOUT_MS    1000
+// Pause before running the ladder again once every step failed
+#define LINK_RETRY_MS           10000
+// TMDS stays off this long so the sink notices the link dropped and retrains
+#define LINK_TMDS_HOLD_MS       50
+
+// Recovery ladder, cheapest first. Carried out by the caller.
+typedef enum {
+    LINK_ACTION_NONE,
+    LINK_ACTION_RECOMMIT,       // Write the current timing again, link stays up
+    LINK_ACTION_TOGGLE_TMDS,    // Drop the TMDS drivers, link_health_tmds_release() says when to raise them
+    LINK_ACTION_REINIT,         // Power cycle the encoder and reprogram the mode
+    LINK_ACTION_COUNT
+} link_action;
+
+typedef struct {
+    uint16_t unlocks;                           // Debounced losses of lock
+    uint16_t recovered[LINK_ACTION_COUNT];      // Relocks after each step, [0] without any
+    uint16_t failures;                          // Times the whole ladder ran without success
+    uint16_t last_relock_ms;                    // Lock lost to lock back of the last recovery
+    uint8_t last_action;                        // Step the last recovery ended on
+} link_health_stats;
+
+// Called with every status poll. active is false while the link is meant to be down
+// (no sink, TMDS off, encoder powering up). Returns the recovery step to run now.
+link_action link_health_update(const bool active, const bool pll_locked);
+void link_health_reset();
+// True once, when the TMDS drivers dropped by LINK_ACTION_TOGGLE_TMDS are due to go back up
+bool link_health_tmds_release();
+bool link_health_tmds_held();
+const link_health_stats *link_health_get_stats();
+
+#endif // __LINK_HEALTH_H__
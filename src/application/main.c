@@ -5,17 +5,34 @@
 #include "stm32f0xx_hal.h"
 #include "../shared/adv7511_i2c.h"
 #include "../shared/adv7511_minimal.h"
+#include "../shared/adv7511_regs.h"
 #include "../shared/adv7511_xbox.h"
 #include "../shared/debug.h"
 #include "../shared/xbox_video_standalone.h"
 #include "../shared/error_handler.h"
 #include "../shared/gpio.h"
+#include "../shared/handoff.h"
+#include "../shared/smbus_ram.h"
 #include "../shared/defines.h"
 #include "smbus_i2c.h"
 #include "xbox_video_bios.h"
+#include "events.h"
+#include "link_health.h"
+#include "mode_store.h"
+#include "adv7511.h"
 
 adv7511 encoder;
 
+// Boot phases in microseconds after HAL_Init(), 0 until reached. Logged once the first BIOS
+// mode is applied and left in RAM for a debugger or emulator to read.
+typedef struct {
+    uint32_t smbus_listen_us;
+    uint32_t encoder_ready_us;
+    uint32_t first_mode_us;
+} boot_timestamps;
+
+boot_timestamps boot_times;
+
 extern void SystemClock_Config(void);
 
 #define VECTOR_TABLE_SIZE 48  // Covers 0xC0 bytes (16 + IRQs)
@@ -30,6 +47,47 @@ void relocate_vector_table_to_ram(void)
 	__HAL_SYSCFG_REMAPMEMORY_SRAM();
 }
 
+static uint32_t boot_time_us(void)
+{
+    // Whole milliseconds from the tick, the rest from how far SysTick counted down
+    uint32_t ms;
+    uint32_t count;
+    do {
+        ms = HAL_GetTick();
+        count = SysTick->VAL;
+    } while (ms != HAL_GetTick());
+
+    const uint32_t per_ms = SysTick->LOAD + 1;
+    return ms * 1000 + (per_ms - 1 - count) * 1000 / per_ms;
+}
+
+static void run_link_action(const link_action action)
+{
+    switch (action) {
+        case LINK_ACTION_RECOMMIT:
+            // Standalone mode reprograms the VIC later in the same pass
+            if (bios_took_over()) {
+                bios_recommit_mode();
+            } else {
+                encoder.vic |= ADV7511_VIC_CHANGED;
+            }
+            break;
+
+        case LINK_ACTION_TOGGLE_TMDS:
+            // Raised again from a later pass once the sink had time to see the link drop
+            adv7511_power_down_tmds();
+            break;
+
+        case LINK_ACTION_REINIT:
+            // The mode is put back once the encoder reports ready
+            adv7511_power_up(&encoder);
+            break;
+
+        default:
+            break;
+    }
+}
+
 int main(void)
 {
     // Allow user to force any of the 3 encoders, only required for vic mode
@@ -52,34 +110,167 @@ int main(void)
 
     init_gpio();
 
-    // EXTI interrupt init
-    HAL_NVIC_SetPriority(EXTI0_1_IRQn, 0, 0);
-    HAL_NVIC_EnableIRQ(EXTI0_1_IRQn);
+    // EXTI interrupt init, PF7 is on the EXTI4_15 line
+    HAL_NVIC_SetPriority(ADV_IRQ_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(ADV_IRQ_IRQn);
 
-    init_adv(&encoder, xb_encoder);
+    // Listen on SMBus first, settings sent while the encoder comes up are applied once it is ready
+    smbus_i2c_init();
+    boot_times.smbus_listen_us = boot_time_us();
+
+    // Most boots end up in the same mode as last time, start with it until the BIOS says otherwise
+    SMBusSettings last_mode;
+    if (mode_store_load(&last_mode)) {
+        smbus_i2c_preload_settings(&last_mode);
+    }
+
+    // Coming from the bootloader the encoder may still be running, don't reset it again
+    adv_handoff handoff;
+    if (handoff_take(&handoff) && (handoff.flags & HANDOFF_INIT_DONE) && handoff.encoder == xb_encoder) {
+        if (init_adv_warm(&encoder, xb_encoder)) {
+            encoder.vic = handoff.vic;
+            debug_log("Took over the encoder from the bootloader\r\n");
+        }
+    } else {
+        init_adv(&encoder, xb_encoder);
+    }
 
     bios_init();
 
-    smbus_i2c_init();
+    // Read the status once before the first interrupt
+    uint32_t next_poll = HAL_GetTick();
+    bool first_power_up = true;
+    bool was_ready = false;
 
     while (true)
     {
         debug_ring_flush();
+        smbus_slave_poll();
+        smbus_ram_poll();
+
+        uint32_t events = event_take();
+
+        if ((int32_t)(HAL_GetTick() - next_poll) >= 0) {
+            next_poll = HAL_GetTick() + EVENT_POLL_INTERVAL_MS;
+            events |= EVENT_POLL;
+        }
 
-        // Check PLL status
-        bool pll_lock = (adv7511_read_register(0x9E) >> 4) & 0x01;
-        set_led_1(pll_lock);
+        // A further interrupt raised before the last one was cleared gives no new edge
+        if ((events & EVENT_POLL) && adv_irq_asserted()) {
+            encoder.interrupt = 1;
+            events |= EVENT_ADV_IRQ;
+        }
 
-        adv_handle_interrupts(&encoder);
+        if (events & EVENT_ADV_IRQ) {
+            adv_handle_interrupts(&encoder);
+        }
 
+        adv7511_commit_poll();
+        adv7511_power_poll(&encoder);
+
+        // A sink that was never plugged in raises no interrupt, check once at start up.
+        // After a later power up the last mode is replayed from the register shadow.
+        if (first_power_up && adv7511_ready(&encoder)) {
+            first_power_up = false;
+            boot_times.encoder_ready_us = boot_time_us();
+            adv7511_check_sink(&encoder);
+        }
+
+        // Apply a mode that arrived while the encoder was coming up right away
+        if (adv7511_ready(&encoder) && !was_ready) {
+            events |= EVENT_SMBUS;
+        }
+        was_ready = adv7511_ready(&encoder);
+
+        // HPD and monitor sense come with the interrupt, PLL lock and the detected VIC don't.
+        // Without a sink the encoder is powered down and there is nothing to poll.
+        const bool sink_absent = encoder.power_state == ADV7511_POWER_OFF;
+        const bool status_updated = (events & EVENT_POLL) && !sink_absent;
+        if (status_updated) {
+            adv7511_read_status(&encoder.status);
+            set_led_1(encoder.status.pll_lock);
+
+            // TMDS is only off on purpose, from the shadow so this costs no bus traffic
+            const bool link_active = adv7511_ready(&encoder) && encoder.hot_plug_detect && adv7511_get_tmds_power_down() == 0;
+            run_link_action(link_health_update(link_active, encoder.status.pll_lock));
+        } else if (sink_absent) {
+            set_led_1(false);
+            link_health_reset();
+        }
+        if (link_health_tmds_release()) {
+            adv7511_power_up_tmds();
+        }
+
+#ifdef ADV7511_I2C_BENCHMARK
+        static uint32_t last_benchmark = 0;
+        if ((HAL_GetTick() - last_benchmark) > 5000) {
+            last_benchmark = HAL_GetTick();
+            adv7511_i2c_benchmark_report();
+        }
+#endif
+
+#ifdef SMBUS_BENCHMARK
+        static uint32_t last_smbus_benchmark = 0;
+        if ((HAL_GetTick() - last_smbus_benchmark) > 5000) {
+            last_smbus_benchmark = HAL_GetTick();
+            smbus_slave_benchmark_report();
+        }
+#endif
+
+        // No BIOS confirmed the stored mode, whatever is running doesn't talk to us
+        if (smbus_i2c_settings_speculative() && HAL_GetTick() > SMBUS_SPECULATIVE_TIMEOUT_MS) {
+            smbus_i2c_drop_speculative();
+            encoder.vic |= ADV7511_VIC_CHANGED;
+        }
+
+        // Mode changes wait until the encoder is up
+        static bool save_pending = false;
         if (bios_took_over()) {
             set_led_2(true);
-            bios_loop(&xb_encoder);
+            if ((events & (EVENT_SMBUS | EVENT_POLL)) && adv7511_ready(&encoder)) {
+                const bool speculative = smbus_i2c_settings_speculative();
+                const bool applied = bios_loop(&xb_encoder);
+
+                // Only settings that came from the BIOS are worth keeping
+                if (applied && !speculative) {
+                    save_pending = true;
+                }
+
+                if (applied && boot_times.first_mode_us == 0) {
+                    boot_times.first_mode_us = boot_time_us();
+                    debug_log("Boot: SMBus listening %uus, encoder ready %uus, first mode %uus\r\n",
+                              (unsigned int)boot_times.smbus_listen_us, (unsigned int)boot_times.encoder_ready_us,
+                              (unsigned int)boot_times.first_mode_us);
+                }
+            }
+
+            // Erasing the page stalls the CPU for tens of ms, wait until the bus is quiet
+            if (save_pending && !smbus_slave_busy() && !smbus_ram_busy()) {
+                save_pending = false;
+                mode_store_save(bios_current_settings());
+            }
         }
         else
         {
             set_led_2(false);
-            stand_alone_loop(&encoder, xb_encoder);
+            if (status_updated && adv7511_ready(&encoder)) {
+                stand_alone_loop(&encoder, xb_encoder);
+            }
+        }
+
+        // Sleep until the next poll unless something needs watching every tick.
+        // Without a sink only HPD or SMBus can change anything.
+        uint32_t timeout = next_poll - HAL_GetTick();
+        if ((int32_t)timeout < 0) {
+            timeout = 0;
+        }
+        if (sink_absent) {
+            timeout = UINT32_MAX;
+        }
+        const bool powering_up = encoder.power_state != ADV7511_POWER_OFF && !adv7511_ready(&encoder);
+        if (powering_up || adv7511_commit_pending() || link_health_tmds_held() || adv7511_i2c_busy() || smbus_slave_busy()) {
+            timeout = 1;
         }
+        event_wait(timeout);
     }
 }
@@ -0,0 +1,83 @@
+#include <stddef.h>
+#include <string.h>
+#include "mode_store.h"
+#include "stm32.h"
+#include "../shared/crc32.h"
+#include "../shared/debug.h"
+#include "../shared/defines.h"
+#include "../shared/flash.h"
+
+#define MODE_STORE_MAGIC    0xA55A
+#define MODE_STORE_ADDRESS  (FLASH_START_ADDRESS + (LAST_MODE_PAGE << FLASH_PAGE_SHIFT))
+
+typedef struct
+{
+    uint16_t magic;
+    SMBusSettings settings;
+    uint32_t crc;           // crc32 of magic and settings
+} mode_record;
+
+#define MODE_STORE_RECORDS ((1 << FLASH_PAGE_SHIFT) / sizeof(mode_record))
+
+_Static_assert((sizeof(mode_record) % 2) == 0, "Flash is programmed in half words");
+
+static const mode_record *record_at(const uint16_t index) {
+    return (const mode_record *)(MODE_STORE_ADDRESS + index * sizeof(mode_record));
+}
+
+static bool record_valid(const mode_record *record) {
+    return record->magic == MODE_STORE_MAGIC && record->crc == crc32_calc((uint32_t)record, offsetof(mode_record, crc));
+}
+
+// Returns the first erased slot, MODE_STORE_RECORDS if the page is full
+static uint16_t mode_store_find(const mode_record **last) {
+    *last = NULL;
+    for (uint16_t i = 0; i < MODE_STORE_RECORDS; i++) {
+        const mode_record *record = record_at(i);
+        if (record->magic == 0xFFFF) {
+            return i;
+        }
+        if (record_valid(record)) {
+            *last = record;
+        }
+    }
+    return MODE_STORE_RECORDS;
+}
+
+bool mode_store_load(SMBusSettings *settings) {
+    const mode_record *last;
+    mode_store_find(&last);
+    if (last == NULL) {
+        return false;
+    }
+
+    memcpy(settings, &last->settings, sizeof(SMBusSettings));
+    return true;
+}
+
+void mode_store_save(const SMBusSettings *settings) {
+    const mode_record *last;
+    uint16_t slot = mode_store_find(&last);
+
+    // The title changes with every game, only what affects the picture counts
+    if (last != NULL && last->settings.encoder == settings->encoder && last->settings.region == settings->region &&
+        last->settings.mode == settings->mode && last->settings.avinfo == settings->avinfo) {
+        return;
+    }
+
+    if (slot >= MODE_STORE_RECORDS) {
+        if (!flash_erase_page(LAST_MODE_PAGE)) {
+            return;
+        }
+        slot = 0;
+    }
+
+    mode_record record;
+    record.magic = MODE_STORE_MAGIC;
+    memcpy(&record.settings, settings, sizeof(SMBusSettings));
+    record.crc = crc32_calc((uint32_t)&record, offsetof(mode_record, crc));
+
+    if (!flash_program((uint32_t)record_at(slot), (const uint8_t *)&record, sizeof(record))) {
+        debug_log("Storing the video mode failed\r\n");
+    }
+}
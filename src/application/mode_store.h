@@ -0,0 +1,17 @@
+#ifndef __MODE_STORE_H__
+#define __MODE_STORE_H__
+
+#include <stdbool.h>
+#include "smbus_i2c.h"
+
+// Last successfully applied BIOS settings in flash (LAST_MODE_PAGE). Records are appended
+// until the page is full, so the page is only erased every MODE_STORE_RECORDS changes.
+
+// Most recent valid record, false if there is none
+bool mode_store_load(SMBusSettings *settings);
+// Appends a record unless the stored encoder, region, mode and avinfo are the same already.
+// Runs from flash and erases synchronously when the page is full, code and interrupts that run
+// from flash (including the SMBus slave) stall for the erase, roughly 20-40 ms.
+void mode_store_save(const SMBusSettings *settings);
+
+#endif // __MODE_STORE_H__
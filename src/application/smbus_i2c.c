@@ -1,510 +1,268 @@
 #include "smbus_i2c.h"
+#include "events.h"
+#include "link_health.h"
 #include "stm32.h"
-#include "flash.h"
+#include "../shared/adv7511_i2c.h"
+#include "../shared/idle.h"
+#include "../shared/smbus_ram.h"
+#include "../shared/smbus_slave.h"
 #include "../shared/debug.h"
 #include "../shared/defines.h"
 #include <string.h>
 
-static I2C_HandleTypeDef hi2c2;
-static uint32_t state = SMBUS_SMS_READY;
 static SMBusSettings scratchSettings = {0};
 static SMBusSettings settings = {0};
+// Bumped after every change of settings. Only the main loop reads, so a copy it took is whole
+// when the count didn't move meanwhile, and a burst of applies reads as just the newest one.
+static volatile uint32_t settings_sequence = 0;
+static uint32_t taken_sequence = 0;
 
 static uint16_t config_buffer_bank = 0;
 static uint16_t config_buffer_index = 0;
 
-static uint16_t ram_buffer_bank = 0;
-static uint16_t ram_buffer_index = 0;
-static uint8_t ram_buffer[RAM_BUFFER_SIZE];
-static uint32_t ram_buffer_crc = 0;
-
-static int currentCommand = -1;  // -1 means no command, otherwise stores command byte
-static uint8_t commandByte = 0;
-static uint8_t dataByte = 0;
-static uint8_t responseByte = 0x42;  // default response
-
-static bool video_mode_update_pending = false;
 static bool bios_took_over_control = false;
+static bool settings_speculative = false;   // Preloaded from flash, not confirmed by the BIOS yet
 
-// -------------------- Initialization --------------------
-void smbus_i2c_init(void)
+static const uint8_t versions[] = { I2C_HDMI_VERSION1, I2C_HDMI_VERSION2, I2C_HDMI_VERSION3, I2C_HDMI_VERSION4 };
+
+// Latches the scratch settings when apply is 1, any write here means the BIOS is in control
+static void config_apply(const uint8_t apply)
 {
-    __HAL_RCC_GPIOB_CLK_ENABLE();
-    __HAL_RCC_I2C2_CLK_ENABLE();
-
-    // I2C2 pins: PB10=SCL, PB11=SDA
-    GPIO_InitTypeDef gpio = {0};
-    gpio.Pin = GPIO_PIN_10 | GPIO_PIN_11;
-    gpio.Mode = GPIO_MODE_AF_OD;
-    gpio.Pull = GPIO_PULLUP;
-    gpio.Speed = GPIO_SPEED_FREQ_HIGH;
-    gpio.Alternate = GPIO_AF1_I2C2;
-    HAL_GPIO_Init(GPIOB, &gpio);
-
-    hi2c2.Instance = I2C2;
-    hi2c2.Init.Timing = 0x00303D5B;
-    hi2c2.Init.OwnAddress1 = (I2C_SLAVE_ADDR << 1);
-    hi2c2.Init.AddressingMode = I2C_ADDRESSINGMODE_7BIT;
-    hi2c2.Init.DualAddressMode = I2C_DUALADDRESS_DISABLE;
-    hi2c2.Init.OwnAddress2 = 0;
-    hi2c2.Init.OwnAddress2Masks = I2C_OA2_NOMASK;
-    hi2c2.Init.GeneralCallMode = I2C_GENERALCALL_DISABLE;
-    hi2c2.Init.NoStretchMode = I2C_NOSTRETCH_DISABLE; // allow clock stretching
-
-    if(HAL_I2C_Init(&hi2c2) != HAL_OK)
-    {
-        debug_log("SMBUS I2C init failed\n");
-        while(1);
-    }
+    bios_took_over_control = true;
+    settings_speculative = false;
 
-    if (HAL_I2CEx_ConfigAnalogFilter(&hi2c2, I2C_ANALOGFILTER_ENABLE) != HAL_OK)
+    if (apply == 0x01)
     {
-        debug_log("SMBUS I2C config analog filter failed\n");
-        while(1);
+        memcpy(&settings, &scratchSettings, sizeof(SMBusSettings));
+        __DMB();
+        settings_sequence++;
+        event_post(EVENT_SMBUS);
+        debug_ring_log("SMBus: encoder=%02X region=%02X mode=%08X title=%08X avinfo=%08X\r\n", settings.encoder, settings.region, settings.mode, settings.titleid, settings.avinfo);
     }
+}
+
+static uint16_t config_buffer_offset(void)
+{
+    return (config_buffer_bank << 8) | config_buffer_index;
+}
 
-    if (HAL_I2CEx_ConfigDigitalFilter(&hi2c2, 0) != HAL_OK)
+static void config_buffer_advance(void)
+{
+    config_buffer_index++;
+    if (config_buffer_index > 0xff)
     {
-        debug_log("SMBUS I2C config digital filter failed\n");
-        while(1);
+        config_buffer_index = 0;
+        config_buffer_bank++;
     }
-
-    HAL_NVIC_SetPriority(I2C2_IRQn, 1, 0);
-    HAL_NVIC_EnableIRQ(I2C2_IRQn);
-
-    // Start listening for master
-    HAL_I2C_EnableListen_IT(&hi2c2);
-
-    state = SMBUS_SMS_READY;
-    currentCommand = -1;
-    debug_log("SMBus: I2C Slave 0x%02X ready\r\n", I2C_SLAVE_ADDR);
 }
 
-// -------------------- Address Match Callback --------------------
-void HAL_I2C_AddrCallback(I2C_HandleTypeDef *hi2c, uint8_t TransferDirection, uint16_t AddrMatchCode)
+static uint8_t saturate(const uint16_t count)
 {
-    if(hi2c->Instance != I2C2) return;
+    return count > 0xff ? 0xff : (uint8_t)count;
+}
 
-    if(TransferDirection == I2C_DIRECTION_RECEIVE)
-    {
-        // Master reads (slave transmits)
-        if ((state & SMBUS_SMS_IGNORED) == SMBUS_SMS_IGNORED)
-        {
-            // Best way not to block the line
-            LL_I2C_TransmitData8(hi2c->Instance, 0xFFU);
-            if (LL_I2C_IsActiveFlag_TCR(hi2c->Instance))
-            {
-                LL_I2C_SetTransferSize(hi2c->Instance, 1);
-            }
-            __HAL_I2C_GENERATE_NACK(hi2c);
-            LL_I2C_ClearFlag_ADDR(hi2c->Instance);
-            state &= ~SMBUS_SMS_IGNORED;
-            HAL_I2C_EnableListen_IT(hi2c);
-        }
-        else
-        {
-            // If we don't have a response yet, try to get one
-            if (!(state & (SMBUS_SMS_READY | SMBUS_SMS_RESPONSE_READY)) && currentCommand != -1)
-            {
-                // Prepare response if we have a command
-                if (currentCommand != -1)
-                {
-                    // Response already prepared in SlaveRxCpltCallback
-                    state |= SMBUS_SMS_RESPONSE_READY;
-                }
-                else
-                {
-                    state |= SMBUS_SMS_IGNORED;
-                    __HAL_I2C_GENERATE_NACK(hi2c);
-                    LL_I2C_ClearFlag_ADDR(hi2c->Instance);
-                    HAL_I2C_EnableListen_IT(hi2c);
-                }
-            }
-
-            if (state & SMBUS_SMS_RESPONSE_READY)
-            {
-                state |= SMBUS_SMS_TRANSMIT;
-                // Disable SBC, cannot NACK on TX
-                LL_I2C_DisableSlaveByteControl(hi2c->Instance);
-                //debug_ring_log("SMBus: AddrR cmd=0x%02X resp=0x%02X\r\n", currentCommand, responseByte);
-                HAL_I2C_Slave_Seq_Transmit_IT(hi2c, &responseByte, 1, I2C_LAST_FRAME);
-            }
-            else
-            {
-                //debug_ring_log("SMBus: AddrR NO_CMD\r\n");
-                __HAL_I2C_GENERATE_NACK(hi2c); // NACK if no command
-                LL_I2C_ClearFlag_ADDR(hi2c->Instance);
-                HAL_I2C_EnableListen_IT(hi2c);
-            }
-        }
-    }
-    else
+// -------------------- Read Commands --------------------
+static uint8_t read_config(const uint8_t command, uint8_t *data, const uint8_t length)
+{
+    uint16_t settings_offset = config_buffer_offset();
+    if (settings_offset >= sizeof(SMBusSettings))
     {
-        // Master writes (slave receives) - new command
-        //debug_ring_log("SMBus: AddrW\r\n");
-        state &= ~SMBUS_SMS_IGNORED;
-
-        if (state & SMBUS_SMS_READY)
-        {
-            state &= ~SMBUS_SMS_READY;
-            state |= SMBUS_SMS_RECEIVE;
-            currentCommand = -1;
-            // Enable SBC so we can NACK
-            LL_I2C_EnableSlaveByteControl(hi2c->Instance);
-            // Use FIRST_FRAME to allow chaining for write commands
-            HAL_I2C_Slave_Seq_Receive_IT(hi2c, &commandByte, 1, I2C_NEXT_FRAME);
-        }
+        data[0] = 0xFF;
+        return 1;
     }
+    data[0] = ((const uint8_t*)&settings)[settings_offset];
+    config_buffer_advance();
+    return 1;
 }
 
-// -------------------- Receive Complete Callback --------------------
-void HAL_I2C_SlaveRxCpltCallback(I2C_HandleTypeDef *hi2c)
+static uint8_t read_version(const uint8_t command, uint8_t *data, const uint8_t length)
 {
-    if(hi2c->Instance != I2C2) return;
+    data[0] = versions[command - I2C_HDMI_COMMAND_READ_VERSION1];
+    return 1;
+}
 
-    if (state & SMBUS_SMS_IGNORED)
-    {
-        __HAL_I2C_GENERATE_NACK(hi2c);
-        if (LL_I2C_IsActiveFlag_TCR(hi2c->Instance))
-        {
-            LL_I2C_SetTransferSize(hi2c->Instance, 1);
-        }
-    }
-    else
-    {
-        if (currentCommand == -1)
-        {
-            state &= ~SMBUS_SMS_RECEIVE;
-
-            // Command byte received
-            currentCommand = commandByte;
-
-            // Read command - prepare response
-            switch(commandByte)
-            {
-                case I2C_HDMI_COMMAND_READ_CONFIG:
-                {
-                    uint16_t settings_size = sizeof(SMBusSettings);
-                    uint16_t settings_offset = (config_buffer_bank << 8) | config_buffer_index;
-                    if (settings_offset >= settings_size)
-                    {
-                        break;
-                    }
-                    uint8_t *settings_data = (uint8_t*)&settings;
-                    responseByte = settings_data[settings_offset];
-                    config_buffer_index++;
-                    if (config_buffer_index > 0xff)
-                    {
-                        config_buffer_index = 0;
-                        config_buffer_bank++;
-                    }
-                    break;
-                }
-                case I2C_HDMI_COMMAND_READ_VERSION1:
-                {
-                    responseByte = I2C_HDMI_VERSION1;
-                    break;
-                }
-                case I2C_HDMI_COMMAND_READ_VERSION2:
-                {
-                    responseByte = I2C_HDMI_VERSION2;
-                    break;
-                }
-                case I2C_HDMI_COMMAND_READ_VERSION3:
-                {
-                    responseByte = I2C_HDMI_VERSION3;
-                    break;
-                }
-                case I2C_HDMI_COMMAND_READ_VERSION4:
-                {
-                    responseByte = I2C_HDMI_VERSION4;
-                    break;
-                }
-                case I2C_HDMI_COMMAND_READ_MODE:
-                {
-                    responseByte = I2C_HDMI_MODE_APPLICATION;
-                    break;
-                }
-                case I2C_HDMI_COMMAND_READ_RAM:
-                {
-                    uint16_t ram_buffer_offset = (ram_buffer_bank << 8) | ram_buffer_index;
-                    if (ram_buffer_offset >= RAM_BUFFER_SIZE)
-                    {
-                        break;
-                    }
-                    responseByte = ram_buffer[ram_buffer_offset];
-                    ram_buffer_index++;
-                    if (ram_buffer_index > 0xff)
-                    {
-                        ram_buffer_index = 0;
-                        ram_buffer_bank++;
-                    }
-                    break;
-                }
-                case I2C_HDMI_COMMAND_READ_RAM_PAGE_CRC1:
-                {
-                    responseByte = (uint8_t)((ram_buffer_crc >> 24) & 0xff);
-                    break;
-                }
-                case I2C_HDMI_COMMAND_READ_RAM_PAGE_CRC2:
-                {
-                    responseByte = (uint8_t)((ram_buffer_crc >> 16) & 0xff);
-                    break;
-                }
-                case I2C_HDMI_COMMAND_READ_RAM_PAGE_CRC3:
-                {
-                    responseByte = (uint8_t)((ram_buffer_crc >> 8) & 0xff);
-                    break;
-                }
-                case I2C_HDMI_COMMAND_READ_RAM_PAGE_CRC4:
-                {
-                    responseByte = (uint8_t)(ram_buffer_crc & 0xff);
-                    break;
-                }
-                default:
-                {
-                    responseByte = 0xFF;
-                    break;
-                }
-            }
-
-
-            if ((currentCommand & I2C_WRITE_BIT) == I2C_WRITE_BIT)
-            {
-                // Write command - receive data byte
-                state |= SMBUS_SMS_RECEIVE;
-                HAL_I2C_Slave_Seq_Receive_IT(hi2c, &dataByte, 1, I2C_LAST_FRAME);
-            }
-            else
-            {
-                // Release the SCL stretch
-                LL_I2C_SetTransferSize(hi2c->Instance, 1);
-            }
-
-        }
-        else
-        {
-            // Block Write, get the size
-            if (state & SMBUS_SMS_PROCESSING)
-            {
-                state &= ~(SMBUS_SMS_PROCESSING | SMBUS_SMS_RECEIVE);
-                state |= SMBUS_SMS_RECEIVE;
-                HAL_I2C_Slave_Seq_Receive_IT(hi2c, &dataByte, 1, I2C_LAST_FRAME);
-            }
-            else
-            {
-                state &= ~SMBUS_SMS_RECEIVE;
-            }
-        }
-    }
+static uint8_t read_mode(const uint8_t command, uint8_t *data, const uint8_t length)
+{
+    data[0] = I2C_HDMI_MODE_APPLICATION;
+    return 1;
 }
 
-// -------------------- Transmit Complete Callback --------------------
-void HAL_I2C_SlaveTxCpltCallback(I2C_HandleTypeDef *hi2c)
+static uint8_t read_adv_recoveries(const uint8_t command, uint8_t *data, const uint8_t length)
 {
-    if(hi2c->Instance != I2C2) return;
-    state &= ~SMBUS_SMS_TRANSMIT;
+    data[0] = saturate(adv7511_i2c_get_stats()->recoveries);
+    return 1;
 }
 
-// -------------------- Listen Complete Callback --------------------
-void HAL_I2C_ListenCpltCallback(I2C_HandleTypeDef *hi2c)
+static uint8_t read_smbus_recoveries(const uint8_t command, uint8_t *data, const uint8_t length)
 {
-    if(hi2c->Instance != I2C2) return;
+    data[0] = saturate(smbus_slave_recoveries());
+    return 1;
+}
 
-    // Process the write if we have a write command and all data was received
-    if(currentCommand != -1 && !(state & SMBUS_SMS_RESPONSE_READY))
+static uint8_t read_idle_percent(const uint8_t command, uint8_t *data, const uint8_t length)
+{
+    data[0] = idle_percent();
+    return 1;
+}
+
+static uint8_t read_link_unlocks(const uint8_t command, uint8_t *data, const uint8_t length)
+{
+    data[0] = saturate(link_health_get_stats()->unlocks);
+    return 1;
+}
+
+// -------------------- Write Commands --------------------
+static uint8_t write_config(const uint8_t command, uint8_t *data, const uint8_t length)
+{
+    uint16_t settings_offset = config_buffer_offset();
+    if (settings_offset < sizeof(SMBusSettings))
     {
-        // Size of bytes received must match expected size
-        // For single-byte writes, XferCount should be 0 (all bytes received)
-        if(hi2c->XferCount == 0)
-        {
-            // Process the write command
-            switch(currentCommand)
-            {
-                case I2C_HDMI_COMMAND_WRITE_CONFIG:
-                {
-                    uint16_t settings_size = sizeof(SMBusSettings);
-                    uint16_t settings_offset = (config_buffer_bank << 8) | config_buffer_index;
-                    if (settings_offset >= settings_size)
-                    {
-                        break;
-                    }
-                    uint8_t *scratch_settings_data = (uint8_t*)&scratchSettings;
-                    scratch_settings_data[settings_offset] = dataByte;
-                    config_buffer_index++;
-                    if (config_buffer_index > 0xff)
-                    {
-                        config_buffer_index = 0;
-                        config_buffer_bank++;
-                    }
-                    break;
-                }
-                case I2C_HDMI_COMMAND_WRITE_CONFIG_BANK:
-                {
-                    config_buffer_bank = dataByte;
-                    config_buffer_index = 0;
-                    break;
-                }
-                case I2C_HDMI_COMMAND_WRITE_CONFIG_INDEX:
-                {
-                     config_buffer_index = dataByte;
-                     break;
-                }
-                case I2C_HDMI_COMMAND_WRITE_CONFIG_APPLY:
-                {
-                    bios_took_over_control = true;
-
-                    if (dataByte == 0x01)
-                    {
-                        memcpy(&settings, &scratchSettings, sizeof(SMBusSettings));
-                        video_mode_update_pending = true;
-                        debug_ring_log("SMBus: encoder=%02X region=%02X mode=%08X title=%08X avinfo=%08X\r\n", settings.encoder, settings.region, settings.mode, settings.titleid, settings.avinfo);
-                    }
-                    break;
-                }
-                case I2C_HDMI_COMMAND_WRITE_SET_MODE:
-                {
-                    if (dataByte == I2C_HDMI_MODE_BOOTLOADER)
-                    {
-                        *BOOTLOADER_FLAG_ADDRESS = BOOTLOADER_MAGIC_VALUE;
-                    }
-                    if (dataByte == I2C_HDMI_MODE_APPLICATION)
-                    {
-                        *BOOTLOADER_FLAG_ADDRESS = 0;
-                    }
-                    HAL_Delay(10);
-                    NVIC_SystemReset();
-                    break;
-                }
-                case I2C_HDMI_COMMAND_WRITE_READ_PAGE:
-                {
-                    ram_buffer_crc = flash_copy_page(dataByte, ram_buffer, RAM_BUFFER_SIZE);
-                    break;
-                }
-                case I2C_HDMI_COMMAND_WRITE_RAM:
-                {
-                    uint16_t ram_offset = (ram_buffer_bank << 8) | ram_buffer_index;
-                    if (ram_offset >= RAM_BUFFER_SIZE)
-                    {
-                        break;
-                    }
-                    ram_buffer[ram_offset] = dataByte;
-                    ram_buffer_index++;
-                    if (ram_buffer_index > 0xff)
-                    {
-                        ram_buffer_index = 0;
-                        ram_buffer_bank++;
-                    }
-                    break;
-                }
-                case I2C_HDMI_COMMAND_WRITE_RAM_BANK:
-                {
-                    ram_buffer_bank = dataByte;
-                    ram_buffer_index = 0;
-                    break;
-                }
-                case I2C_HDMI_COMMAND_WRITE_RAM_INDEX:
-                {
-                    ram_buffer_index = dataByte;
-                    break;
-                }
-                case I2C_HDMI_COMMAND_WRITE_RAM_APPLY:
-                {
-                    if (dataByte >= (BOOTLOADER_SIZE >> FLASH_PAGE_SHIFT) && dataByte < (FLASH_TOTAL_SIZE >> FLASH_PAGE_SHIFT))
-                    {
-                        return;
-                    }
-                    flash_erase_page(dataByte);
-                    flash_write_page(dataByte, ram_buffer, RAM_BUFFER_SIZE);
-                    break;
-                }
-            }
-        }
+        ((uint8_t*)&scratchSettings)[settings_offset] = data[0];
+        config_buffer_advance();
     }
+    return 0;
+}
 
-    // Reset state
-    state = SMBUS_SMS_READY;
-    currentCommand = -1;
+static uint8_t write_config_bank(const uint8_t command, uint8_t *data, const uint8_t length)
+{
+    config_buffer_bank = data[0];
+    config_buffer_index = 0;
+    return 0;
+}
 
-    // Do it all again
-    HAL_I2C_EnableListen_IT(hi2c);
+static uint8_t write_config_index(const uint8_t command, uint8_t *data, const uint8_t length)
+{
+    config_buffer_index = data[0];
+    return 0;
 }
 
-// -------------------- Error Callback --------------------
-void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+static uint8_t write_config_apply(const uint8_t command, uint8_t *data, const uint8_t length)
 {
-    if(hi2c->Instance != I2C2) return;
+    config_apply(data[0]);
+    return 0;
+}
 
-    uint32_t err = hi2c->ErrorCode;
+// Packed settings followed by the apply value, the engine already checked the length
+static uint8_t write_config_block(const uint8_t command, uint8_t *data, const uint8_t length)
+{
+    memcpy(&scratchSettings, data, sizeof(SMBusSettings));
+    config_apply(data[sizeof(SMBusSettings)]);
+    return 0;
+}
 
-    if (err & (HAL_I2C_ERROR_BERR | HAL_I2C_ERROR_TIMEOUT))
-    {
-        // Critical error - reset the stack
-        if(state & (SMBUS_SMS_TRANSMIT | SMBUS_SMS_RECEIVE | SMBUS_SMS_PROCESSING))
-        {
-            __HAL_I2C_DISABLE(hi2c);
-            while (LL_I2C_IsEnabled(hi2c->Instance)) {}
-            __HAL_I2C_ENABLE(hi2c);
-            if(hi2c->State != HAL_I2C_STATE_READY)
-            {
-                HAL_I2C_DeInit(hi2c);
-                HAL_I2C_Init(hi2c);
-                HAL_I2C_EnableListen_IT(hi2c);
-            }
-        }
-        state = SMBUS_SMS_READY;
-        currentCommand = -1;
-    }
-    else if (err & HAL_I2C_ERROR_ARLO)
+static uint8_t write_set_mode(const uint8_t command, uint8_t *data, const uint8_t length)
+{
+    if (data[0] == I2C_HDMI_MODE_BOOTLOADER)
     {
-        // Arbitration lost - signal error
-        state = SMBUS_SMS_READY;
-        currentCommand = -1;
-        HAL_I2C_EnableListen_IT(hi2c);
+        *BOOTLOADER_FLAG_ADDRESS = BOOTLOADER_MAGIC_VALUE;
     }
-    else if (err & HAL_I2C_ERROR_AF)
+    if (data[0] == I2C_HDMI_MODE_APPLICATION)
     {
-        // NACK - expected at end of read, handle gracefully
-        hi2c->PreviousState = hi2c->State;
-        hi2c->State = HAL_I2C_STATE_READY;
-        __HAL_UNLOCK(hi2c);
-        state = SMBUS_SMS_READY;
-        currentCommand = -1;
-        HAL_I2C_EnableListen_IT(hi2c);
+        *BOOTLOADER_FLAG_ADDRESS = 0;
     }
-    else if(err != HAL_I2C_ERROR_NONE)
+    smbus_ram_request_reset();
+    return 0;
+}
+
+// The running application can't overwrite itself
+static uint8_t write_ram_apply(const uint8_t command, uint8_t *data, const uint8_t length)
+{
+    if (data[0] >= (BOOTLOADER_SIZE >> FLASH_PAGE_SHIFT) && data[0] < (FLASH_TOTAL_SIZE >> FLASH_PAGE_SHIFT))
     {
-        state = SMBUS_SMS_READY;
-        currentCommand = -1;
-        HAL_I2C_EnableListen_IT(hi2c);
+        return 0;
     }
+    smbus_ram_queue(SMBUS_RAM_APPLY, data[0]);
+    return 0;
 }
 
-bool video_mode_updated() {
-    return video_mode_update_pending;
-}
+// -------------------- Command Table --------------------
+static const smbus_command reads[] = {
+    [I2C_HDMI_COMMAND_READ_CONFIG] = { SMBUS_BYTE, 0, read_config },
+    [I2C_HDMI_COMMAND_READ_VERSION1] = { SMBUS_BYTE, 0, read_version },
+    [I2C_HDMI_COMMAND_READ_VERSION2] = { SMBUS_BYTE, 0, read_version },
+    [I2C_HDMI_COMMAND_READ_VERSION3] = { SMBUS_BYTE, 0, read_version },
+    [I2C_HDMI_COMMAND_READ_VERSION4] = { SMBUS_BYTE, 0, read_version },
+    [I2C_HDMI_COMMAND_READ_MODE] = { SMBUS_BYTE, 0, read_mode },
+    [I2C_HDMI_COMMAND_READ_RAM] = { SMBUS_BYTE, 0, smbus_ram_read },
+    [I2C_HDMI_COMMAND_READ_RAM_PAGE_CRC1] = { SMBUS_BYTE, 0, smbus_ram_read_crc },
+    [I2C_HDMI_COMMAND_READ_RAM_PAGE_CRC2] = { SMBUS_BYTE, 0, smbus_ram_read_crc },
+    [I2C_HDMI_COMMAND_READ_RAM_PAGE_CRC3] = { SMBUS_BYTE, 0, smbus_ram_read_crc },
+    [I2C_HDMI_COMMAND_READ_RAM_PAGE_CRC4] = { SMBUS_BYTE, 0, smbus_ram_read_crc },
+    [I2C_HDMI_COMMAND_READ_ADV_I2C_RECOVERIES] = { SMBUS_BYTE, 0, read_adv_recoveries },
+    [I2C_HDMI_COMMAND_READ_SMBUS_RECOVERIES] = { SMBUS_BYTE, 0, read_smbus_recoveries },
+    [I2C_HDMI_COMMAND_READ_IDLE_PERCENT] = { SMBUS_BYTE, 0, read_idle_percent },
+    [I2C_HDMI_COMMAND_READ_LINK_UNLOCKS] = { SMBUS_BYTE, 0, read_link_unlocks },
+    [I2C_HDMI_COMMAND_READ_RAM_BLOCK] = { SMBUS_BLOCK, 0, smbus_ram_read_block },
+    [I2C_HDMI_COMMAND_READ_FLASH_STATUS] = { SMBUS_BLOCK, 0, smbus_ram_read_status },
+};
+
+static const smbus_command writes[] = {
+    [SMBUS_WRITE_INDEX(I2C_HDMI_COMMAND_WRITE_CONFIG)] = { SMBUS_BYTE, 0, write_config },
+    [SMBUS_WRITE_INDEX(I2C_HDMI_COMMAND_WRITE_CONFIG_BANK)] = { SMBUS_BYTE, 0, write_config_bank },
+    [SMBUS_WRITE_INDEX(I2C_HDMI_COMMAND_WRITE_CONFIG_INDEX)] = { SMBUS_BYTE, 0, write_config_index },
+    [SMBUS_WRITE_INDEX(I2C_HDMI_COMMAND_WRITE_CONFIG_APPLY)] = { SMBUS_BYTE, 0, write_config_apply },
+    [SMBUS_WRITE_INDEX(I2C_HDMI_COMMAND_WRITE_SET_MODE)] = { SMBUS_BYTE, 0, write_set_mode },
+    [SMBUS_WRITE_INDEX(I2C_HDMI_COMMAND_WRITE_READ_PAGE)] = { SMBUS_BYTE, 0, smbus_ram_read_page },
+    [SMBUS_WRITE_INDEX(I2C_HDMI_COMMAND_WRITE_RAM)] = { SMBUS_BYTE, 0, smbus_ram_write, smbus_ram_writable },
+    [SMBUS_WRITE_INDEX(I2C_HDMI_COMMAND_WRITE_RAM_BANK)] = { SMBUS_BYTE, 0, smbus_ram_write_bank },
+    [SMBUS_WRITE_INDEX(I2C_HDMI_COMMAND_WRITE_RAM_INDEX)] = { SMBUS_BYTE, 0, smbus_ram_write_index },
+    [SMBUS_WRITE_INDEX(I2C_HDMI_COMMAND_WRITE_RAM_APPLY)] = { SMBUS_BYTE, 0, write_ram_apply },
+    [SMBUS_WRITE_INDEX(I2C_HDMI_COMMAND_WRITE_RAM_BLOCK)] = { SMBUS_BLOCK, 0, smbus_ram_write_block, smbus_ram_writable },
+    [SMBUS_WRITE_INDEX(I2C_HDMI_COMMAND_WRITE_CONFIG_BLOCK)] = { SMBUS_BLOCK, sizeof(SMBusSettings) + 1, write_config_block },
+};
+
+static const smbus_command_table commands = {
+    reads, sizeof(reads) / sizeof(reads[0]),
+    writes, sizeof(writes) / sizeof(writes[0]),
+};
 
-void ack_video_mode_update() {
-    video_mode_update_pending = false;
+void smbus_i2c_init(void)
+{
+    smbus_slave_init(&commands);
 }
 
-const SMBusSettings * const getSMBusSettings() {
-    return &settings;
+bool smbus_i2c_take_settings(SMBusSettings *latest) {
+    uint32_t sequence = settings_sequence;
+    if (sequence == taken_sequence) {
+        return false;
+    }
+
+    // An apply landing in the middle of the copy moves the count, go again
+    do {
+        sequence = settings_sequence;
+        __DMB();
+        memcpy(latest, &settings, sizeof(SMBusSettings));
+        __DMB();
+    } while (sequence != settings_sequence);
+
+    taken_sequence = sequence;
+    return true;
 }
 
 bool bios_took_over() {
     return bios_took_over_control;
 }
 
-// -------------------- IRQ Handler --------------------
-void I2C2_IRQHandler(void)
-{
-    if (hi2c2.Instance->ISR & (I2C_FLAG_BERR | I2C_FLAG_ARLO | I2C_FLAG_OVR | I2C_FLAG_TIMEOUT | I2C_FLAG_ALERT | I2C_FLAG_PECERR))
-    {
-        HAL_I2C_ER_IRQHandler(&hi2c2);
+void smbus_i2c_preload_settings(const SMBusSettings *preload) {
+    HAL_NVIC_DisableIRQ(I2C2_IRQn);
+    if (!bios_took_over_control) {
+        memcpy(&settings, preload, sizeof(SMBusSettings));
+        settings_sequence++;
+        settings_speculative = true;
+        bios_took_over_control = true;
     }
-    else
-    {
-        HAL_I2C_EV_IRQHandler(&hi2c2);
+    HAL_NVIC_EnableIRQ(I2C2_IRQn);
+}
+
+bool smbus_i2c_settings_speculative() {
+    return settings_speculative;
+}
+
+void smbus_i2c_drop_speculative() {
+    HAL_NVIC_DisableIRQ(I2C2_IRQn);
+    if (settings_speculative) {
+        settings_speculative = false;
+        bios_took_over_control = false;
     }
+    HAL_NVIC_EnableIRQ(I2C2_IRQn);
 }
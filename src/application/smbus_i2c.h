@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include "../shared/smbus_slave.h"
 
 #pragma pack(1)
 typedef struct
@@ -17,12 +18,15 @@ typedef struct
 
 void smbus_i2c_init();
 
-bool video_mode_updated();
-
-void ack_video_mode_update();
-
-const SMBusSettings * const getSMBusSettings();
+// Copies the newest settings if they changed since the last call, earlier ones are skipped
+bool smbus_i2c_take_settings(SMBusSettings *latest);
 
 bool bios_took_over();
 
+// Stored settings applied at boot act as if the BIOS sent them until it sends its own
+void smbus_i2c_preload_settings(const SMBusSettings *preload);
+bool smbus_i2c_settings_speculative();
+// Gives standalone mode back if the BIOS never confirmed the preloaded settings
+void smbus_i2c_drop_speculative();
+
 #endif // __SMBUS_I2C_H__
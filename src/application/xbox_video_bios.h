@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include "../shared/types.h"
+#include "smbus_i2c.h"
 
 typedef enum {
     VIDEO_REGION_NTSCM = 0x00000100,
@@ -25,6 +26,8 @@ typedef enum {
 #define XBOX_AVINFO_INTERLACED         0x00200000
 #define XBOX_AVINFO_FILED              0x01000000
 
+// The tables below are expanded into register programs by scripts/generate_video_programs.py
+// (xbox_video_programs.h), regenerate it after changing them
 #pragma pack(1)
 typedef struct {
     uint16_t hs_delay;          // Increase value to push picture left
@@ -103,6 +106,11 @@ static const VideoMode FOCUS_TABLE[] = {
 };
 
 void bios_init();
-void bios_loop(xbox_encoder * xb_encoder);
+// Applies new settings from SMBus, true if a mode was programmed
+bool bios_loop(xbox_encoder * xb_encoder);
+// Writes the programmed mode again without dropping TMDS
+void bios_recommit_mode();
+// Settings the programmed mode came from
+const SMBusSettings *bios_current_settings();
 
 #endif // __XBOX_VIDEO_BIOS_H__
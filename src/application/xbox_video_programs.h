@@ -0,0 +1,511 @@
+// Generated by scripts/generate_video_programs.py from xbox_video_bios.h, do not edit
+
+#ifndef __XBOX_VIDEO_PROGRAMS_H__
+#define __XBOX_VIDEO_PROGRAMS_H__
+
+#include "../shared/adv7511_vic.h"
+#include "adv7511_program.h"
+
+#define BIOS_MODE_COUNT 18
+
+// Runs before every mode program
+static const uint8_t BIOS_PROGRAM_PROLOGUE[] = {
+    ADV7511_OP_WRITE, 0x3B, 1, 0b01100000, // Force pixel repeat to 1 (for forcing VIC)
+    ADV7511_OP_UPDATE | ADV7511_OP_IF_RGB, 0x18, 0b10000000, 0b10000000, // Convert RGB to YCbCr
+    ADV7511_OP_UPDATE | ADV7511_OP_IF_YCBCR, 0x18, 0b10000000, 0b00000000,
+    ADV7511_OP_END
+};
+
+// Runs after every mode program, AVI infoframe aspect ratio
+static const uint8_t BIOS_PROGRAM_EPILOGUE[] = {
+    ADV7511_OP_UPDATE, 0x4A, 0b01000000, 0b01000000, // Start AVI Infoframe Update
+    ADV7511_OP_UPDATE, 0x55, 0b01100000, 0b01000000, // YCbCr 4:4:4
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x56, 1, 0b00011000, // 4:3
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x56, 1, 0b00101000, // 16:9
+    ADV7511_OP_UPDATE, 0x4A, 0b01000000, 0b00000000, // End AVI Infoframe Update
+    ADV7511_OP_END
+};
+
+// 41 unique programs, 1681 bytes
+static const uint8_t BIOS_PROGRAM_POOL[] = {
+    // @0: CONEXANT 01 640x480_NTSC_RGB OK
+    ADV7511_OP_WRITE, 0x35, 2, 0x1E, 0xA2,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0x00, 0x1E, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x03, 0x42, 0x00, 0x28, 0x03, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_03_480p_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_02_480p_60__4_3,
+    ADV7511_OP_END,
+    // @41: CONEXANT 02 720x480_NTSC_RGB OK
+    ADV7511_OP_WRITE, 0x35, 2, 0x21, 0xA2,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0xA0, 0x1E, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x03, 0xC2, 0x00, 0x28, 0x03, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_03_480p_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_02_480p_60__4_3,
+    ADV7511_OP_END,
+    // @82: CONEXANT 03 640x480_PAL_RGB OK
+    ADV7511_OP_WRITE, 0x35, 2, 0x3F, 0xA4,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0x00, 0x1E, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x0D, 0xC2, 0x00, 0x20, 0x03, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_03_480p_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_02_480p_60__4_3,
+    ADV7511_OP_END,
+    // @123: CONEXANT 04 720x480_PAL_RGB OK
+    ADV7511_OP_WRITE, 0x35, 2, 0x43, 0xA4,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0xA0, 0x1E, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x0E, 0xC2, 0x00, 0x20, 0x03, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_03_480p_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_02_480p_60__4_3,
+    ADV7511_OP_END,
+    // @164: CONEXANT 05 640x576_PAL_RGB Cropped vertically
+    ADV7511_OP_WRITE, 0x35, 2, 0x21, 0x27,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0x00, 0x24, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x03, 0xC2, 0x00, 0x24, 0x03, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_17_576p_50__4_3,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_18_576p_50_16_9,
+    ADV7511_OP_END,
+    // @205: CONEXANT 06 720x576_PAL_RGB Cropped vertically
+    ADV7511_OP_WRITE, 0x35, 2, 0x25, 0x27,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0xA0, 0x24, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x04, 0x42, 0x10, 0x24, 0x03, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_17_576p_50__4_3,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_18_576p_50_16_9,
+    ADV7511_OP_END,
+    // @246: CONEXANT 07 640x480_480P OK; CONEXANT 08 720x480_480P OK; FOCUS 11 640x480_FPAR_480P OK, Pillar boxed
+    ADV7511_OP_WRITE, 0x35, 2, 0x1D, 0xE4,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0xA0, 0x1E, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x04, 0x43, 0xF0, 0x20, 0x06, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_03_480p_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_02_480p_60__4_3,
+    ADV7511_OP_END,
+    // @287: CONEXANT 09 960x720 ?; XCALIBUR 09 960x720 ?
+    ADV7511_OP_WRITE, 0x35, 2, 0x4B, 0x19,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x07, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0x80, 0x2D, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x11, 0x45, 0x00, 0x10, 0x05, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_00_VIC_Unavailable,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_00_VIC_Unavailable,
+    ADV7511_OP_END,
+    // @328: CONEXANT 0A 720p ?; CONEXANT 0B 720p_60 OK; FOCUS 0A 720p ?
+    ADV7511_OP_WRITE, 0x35, 2, 0x4A, 0xD9,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x0A, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0x00, 0x2D, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x11, 0x45, 0x00, 0x10, 0x05, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_04_720p_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_04_720p_60_16_9,
+    ADV7511_OP_END,
+    // @369: CONEXANT 0C 1440x1080 ?; FOCUS 0C 1440x1080 ?; XCALIBUR 0C 1440x1080 ?
+    ADV7511_OP_WRITE, 0x35, 2, 0x3B, 0x28,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x0B, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0x40, 0x43, 0x80,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x0A, 0xC5, 0x80, 0x10, 0x0A, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_00_VIC_Unavailable,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_00_VIC_Unavailable,
+    ADV7511_OP_END,
+    // @410: CONEXANT 0D 1080 ?; FOCUS 0D 1080 ?; XCALIBUR 0D 1080 ?
+    ADV7511_OP_WRITE, 0x35, 2, 0x3B, 0x28,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x0F, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0x00, 0x43, 0x80,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x0A, 0xC5, 0x80, 0x10, 0x0A, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_05_1080i_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_05_1080i_60_16_9,
+    ADV7511_OP_END,
+    // @451: CONEXANT 0E 1080i Untested; FOCUS 0E 1080i ?
+    ADV7511_OP_WRITE, 0x35, 2, 0x3A, 0xE9,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x0F, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0x00, 0x43, 0x80,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x0B, 0x05, 0x80, 0x0C, 0x0A, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_05_1080i_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_05_1080i_60_16_9,
+    ADV7511_OP_END,
+    // @492: CONEXANT 0E 1080i Untested (interlaced); FOCUS 0E 1080i ? (interlaced)
+    ADV7511_OP_WRITE, 0x35, 2, 0x3A, 0xD4,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x0F, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0x00, 0x21, 0xC0,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x0B, 0x05, 0x80, 0x0C, 0x0A, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_05_1080i_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_05_1080i_60_16_9,
+    ADV7511_OP_END,
+    // @533: CONEXANT 0F 640x480_FPAR_NTSC_RGB OK
+    ADV7511_OP_WRITE, 0x35, 2, 0x29, 0x62,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0x00, 0x1E, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x0C, 0x02, 0x00, 0x28, 0x03, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_03_480p_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_02_480p_60__4_3,
+    ADV7511_OP_END,
+    // @574: CONEXANT 10 640x480_FPAR_PAL_RGB OK
+    ADV7511_OP_WRITE, 0x35, 2, 0x4F, 0xA2,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0x00, 0x1E, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x16, 0xC2, 0x00, 0x28, 0x03, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_03_480p_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_02_480p_60__4_3,
+    ADV7511_OP_END,
+    // @615: CONEXANT 11 640x480_FPAR_480P OK, Pillar boxed
+    ADV7511_OP_WRITE, 0x35, 2, 0x1E, 0x24,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0xA0, 0x1E, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x04, 0x43, 0xF0, 0x20, 0x06, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_03_480p_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_02_480p_60__4_3,
+    ADV7511_OP_END,
+    // @656: CONEXANT 12 640x576_FPAR_PAL_RGB Cropped vertically
+    ADV7511_OP_WRITE, 0x35, 2, 0x2C, 0xE7,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0x00, 0x24, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x0C, 0x02, 0x00, 0x24, 0x03, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_17_576p_50__4_3,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_18_576p_50_16_9,
+    ADV7511_OP_END,
+    // @697: FOCUS 01 640x480_NTSC_RGB OK; FOCUS 0F 640x480_FPAR_NTSC_RGB OK
+    ADV7511_OP_WRITE, 0x35, 2, 0x2C, 0xDA,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0x00, 0x1E, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x1C, 0xC4, 0x00, 0x48, 0x02, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_03_480p_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_02_480p_60__4_3,
+    ADV7511_OP_END,
+    // @738: FOCUS 02 720x480_NTSC_RGB OK
+    ADV7511_OP_WRITE, 0x35, 2, 0x22, 0xDA,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0xA0, 0x1E, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x12, 0xC4, 0x00, 0x48, 0x02, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_03_480p_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_02_480p_60__4_3,
+    ADV7511_OP_END,
+    // @779: FOCUS 03 640x480_PAL_RGB OK; FOCUS 10 640x480_FPAR_PAL_RGB OK
+    ADV7511_OP_WRITE, 0x35, 2, 0x23, 0xD8,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0x00, 0x1E, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x13, 0xC4, 0x00, 0x50, 0x02, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_03_480p_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_02_480p_60__4_3,
+    ADV7511_OP_END,
+    // @820: FOCUS 04 720x480_PAL_RGB OK, Borked colors
+    ADV7511_OP_WRITE, 0x35, 2, 0x19, 0xD8,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0xA0, 0x1E, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x0E, 0xC4, 0x00, 0x50, 0x02, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_03_480p_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_02_480p_60__4_3,
+    ADV7511_OP_END,
+    // @861: FOCUS 05 640x576_PAL_RGB OK; FOCUS 12 640x576_FPAR_PAL_RGB OK
+    ADV7511_OP_WRITE, 0x35, 2, 0x23, 0xDA,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0x00, 0x24, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x13, 0xC4, 0x00, 0x58, 0x02, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_17_576p_50__4_3,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_18_576p_50_16_9,
+    ADV7511_OP_END,
+    // @902: FOCUS 06 720x576_PAL_RGB OK, Borked colors
+    ADV7511_OP_WRITE, 0x35, 2, 0x19, 0xDA,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0xA0, 0x24, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x0E, 0xC4, 0x00, 0x58, 0x02, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_17_576p_50__4_3,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_18_576p_50_16_9,
+    ADV7511_OP_END,
+    // @943: FOCUS 07 640x480_480P OK; FOCUS 08 720x480_480P OK
+    ADV7511_OP_WRITE, 0x35, 2, 0x1D, 0xE6,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0xA0, 0x1E, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x04, 0x43, 0xF0, 0x20, 0x06, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_03_480p_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_02_480p_60__4_3,
+    ADV7511_OP_END,
+    // @984: FOCUS 09 960x720 ?
+    ADV7511_OP_WRITE, 0x35, 2, 0x4A, 0xD9,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x07, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0x80, 0x2D, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x11, 0x45, 0x00, 0x10, 0x05, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_00_VIC_Unavailable,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_00_VIC_Unavailable,
+    ADV7511_OP_END,
+    // @1025: FOCUS 0B 720p_60 OK
+    ADV7511_OP_WRITE, 0x35, 2, 0x4A, 0xDB,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x0A, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0x00, 0x2D, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x11, 0x45, 0x00, 0x10, 0x05, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_04_720p_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_04_720p_60_16_9,
+    ADV7511_OP_END,
+    // @1066: XCALIBUR 01 640x480_NTSC_RGB OK
+    ADV7511_OP_WRITE, 0x35, 2, 0x17, 0xE5,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0x00, 0x1E, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x0A, 0xC0, 0x20, 0x1C, 0x02, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_03_480p_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_02_480p_60__4_3,
+    ADV7511_OP_END,
+    // @1107: XCALIBUR 02 720x480_NTSC_RGB OK
+    ADV7511_OP_WRITE, 0x35, 2, 0x17, 0xE5,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0xA0, 0x1E, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x0A, 0x40, 0x60, 0x1C, 0x06, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_03_480p_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_02_480p_60__4_3,
+    ADV7511_OP_END,
+    // @1148: XCALIBUR 03 640x480_PAL_RGB OK
+    ADV7511_OP_WRITE, 0x35, 2, 0x17, 0xE6,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0x00, 0x1E, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x0F, 0xC1, 0x80, 0x04, 0x0A, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_03_480p_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_02_480p_60__4_3,
+    ADV7511_OP_END,
+    // @1189: XCALIBUR 04 720x480_PAL_RGB OK
+    ADV7511_OP_WRITE, 0x35, 2, 0x22, 0x66,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0xA0, 0x1E, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x0A, 0x43, 0x20, 0x04, 0x0A, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_03_480p_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_02_480p_60__4_3,
+    ADV7511_OP_END,
+    // @1230: XCALIBUR 05 640x576_PAL_RGB OK
+    ADV7511_OP_WRITE, 0x35, 2, 0x23, 0xA9,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0x00, 0x24, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x1F, 0xC2, 0xF0, 0x18, 0x06, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_17_576p_50__4_3,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_18_576p_50_16_9,
+    ADV7511_OP_END,
+    // @1271: XCALIBUR 06 720x576_PAL_RGB OK
+    ADV7511_OP_WRITE, 0x35, 2, 0x22, 0x6A,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0xA0, 0x24, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x01, 0x42, 0xD0, 0x18, 0x06, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_17_576p_50__4_3,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_18_576p_50_16_9,
+    ADV7511_OP_END,
+    // @1312: XCALIBUR 07 640x480_480P OK
+    ADV7511_OP_WRITE, 0x35, 2, 0x17, 0xE4,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0x00, 0x1E, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x0A, 0xC0, 0x20, 0x20, 0x05, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_03_480p_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_02_480p_60__4_3,
+    ADV7511_OP_END,
+    // @1353: XCALIBUR 08 720x480_480P OK
+    ADV7511_OP_WRITE, 0x35, 2, 0x17, 0xE4,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0xA0, 0x1E, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x0A, 0x40, 0x60, 0x20, 0x05, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_03_480p_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_02_480p_60__4_3,
+    ADV7511_OP_END,
+    // @1394: XCALIBUR 0A 720p ?; XCALIBUR 0B 720p_60 OK
+    ADV7511_OP_WRITE, 0x35, 2, 0x40, 0xD9,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x0A, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0x00, 0x2D, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x1B, 0x82, 0x80, 0x14, 0x05, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_04_720p_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_04_720p_60_16_9,
+    ADV7511_OP_END,
+    // @1435: XCALIBUR 0E 1080i Untested
+    ADV7511_OP_WRITE, 0x35, 2, 0x2E, 0xE9,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x0F, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0x00, 0x43, 0x80,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x17, 0x02, 0x80, 0x0C, 0x0A, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_05_1080i_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_05_1080i_60_16_9,
+    ADV7511_OP_END,
+    // @1476: XCALIBUR 0E 1080i Untested (interlaced)
+    ADV7511_OP_WRITE, 0x35, 2, 0x2E, 0xD4,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x0F, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0x00, 0x21, 0xC0,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x17, 0x02, 0x80, 0x0C, 0x0A, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_05_1080i_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_05_1080i_60_16_9,
+    ADV7511_OP_END,
+    // @1517: XCALIBUR 0F 640x480_FPAR_NTSC_RGB OK
+    ADV7511_OP_WRITE, 0x35, 2, 0x22, 0x25,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0x00, 0x1E, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x14, 0x40, 0x10, 0x1C, 0x06, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_03_480p_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_02_480p_60__4_3,
+    ADV7511_OP_END,
+    // @1558: XCALIBUR 10 640x480_FPAR_PAL_RGB OK
+    ADV7511_OP_WRITE, 0x35, 2, 0x2C, 0x66,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0x00, 0x1E, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x14, 0x42, 0xA0, 0x04, 0x0A, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_03_480p_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_02_480p_60__4_3,
+    ADV7511_OP_END,
+    // @1599: XCALIBUR 11 640x480_FPAR_480P OK, Pillar boxed
+    ADV7511_OP_WRITE, 0x35, 2, 0x17, 0xA4,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0xA0, 0x1E, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x0A, 0x40, 0x60, 0x20, 0x05, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_03_480p_60_16_9,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_02_480p_60__4_3,
+    ADV7511_OP_END,
+    // @1640: XCALIBUR 12 640x576_FPAR_PAL_RGB OK
+    ADV7511_OP_WRITE, 0x35, 2, 0x23, 0xA9,
+    ADV7511_OP_UPDATE, 0x37, 0x1F, 0x05, // 0x37 is shared with interlaced
+    ADV7511_OP_WRITE, 0x38, 3, 0x00, 0x24, 0x00,
+    ADV7511_OP_WRITE, 0xD7, 6, 0x15, 0xC0, 0x70, 0x18, 0x06, 0x00,
+    ADV7511_OP_UPDATE, 0x41, 0x02, 0x02, // Enable settings
+    ADV7511_OP_UPDATE, 0xD0, 0x02, 0x02, // Fixes jumping for 1080i
+    ADV7511_OP_WRITE | ADV7511_OP_IF_NARROW, 0x3C, 1, VIC_17_576p_50__4_3,
+    ADV7511_OP_WRITE | ADV7511_OP_IF_WIDE, 0x3C, 1, VIC_18_576p_50_16_9,
+    ADV7511_OP_END,
+};
+
+typedef struct {
+    uint16_t progressive;  // Offsets into BIOS_PROGRAM_POOL
+    uint16_t interlaced;
+} bios_mode_program;
+
+static const bios_mode_program CONEXANT_PROGRAMS[BIOS_MODE_COUNT] = {
+    {   0,    0}, // 01
+    {  41,   41}, // 02
+    {  82,   82}, // 03
+    { 123,  123}, // 04
+    { 164,  164}, // 05
+    { 205,  205}, // 06
+    { 246,  246}, // 07
+    { 246,  246}, // 08
+    { 287,  287}, // 09
+    { 328,  328}, // 0A
+    { 328,  328}, // 0B
+    { 369,  369}, // 0C
+    { 410,  410}, // 0D
+    { 451,  492}, // 0E
+    { 533,  533}, // 0F
+    { 574,  574}, // 10
+    { 615,  615}, // 11
+    { 656,  656}, // 12
+};
+
+static const bios_mode_program FOCUS_PROGRAMS[BIOS_MODE_COUNT] = {
+    { 697,  697}, // 01
+    { 738,  738}, // 02
+    { 779,  779}, // 03
+    { 820,  820}, // 04
+    { 861,  861}, // 05
+    { 902,  902}, // 06
+    { 943,  943}, // 07
+    { 943,  943}, // 08
+    { 984,  984}, // 09
+    { 328,  328}, // 0A
+    {1025, 1025}, // 0B
+    { 369,  369}, // 0C
+    { 410,  410}, // 0D
+    { 451,  492}, // 0E
+    { 697,  697}, // 0F
+    { 779,  779}, // 10
+    { 246,  246}, // 11
+    { 861,  861}, // 12
+};
+
+static const bios_mode_program XCALIBUR_PROGRAMS[BIOS_MODE_COUNT] = {
+    {1066, 1066}, // 01
+    {1107, 1107}, // 02
+    {1148, 1148}, // 03
+    {1189, 1189}, // 04
+    {1230, 1230}, // 05
+    {1271, 1271}, // 06
+    {1312, 1312}, // 07
+    {1353, 1353}, // 08
+    { 287,  287}, // 09
+    {1394, 1394}, // 0A
+    {1394, 1394}, // 0B
+    { 369,  369}, // 0C
+    { 410,  410}, // 0D
+    {1435, 1476}, // 0E
+    {1517, 1517}, // 0F
+    {1558, 1558}, // 10
+    {1599, 1599}, // 11
+    {1640, 1640}, // 12
+};
+
+#endif // __XBOX_VIDEO_PROGRAMS_H__
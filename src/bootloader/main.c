@@ -9,6 +9,9 @@
 #include "../shared/error_handler.h"
 #include "../shared/xbox_video_standalone.h"
 #include "../shared/gpio.h"
+#include "../shared/idle.h"
+#include "../shared/handoff.h"
+#include "../shared/smbus_ram.h"
 #include "smbus_i2c.h"
 
 extern void SystemClock_Config(void);
@@ -99,10 +102,26 @@ void enter_bootloader_mode(void)
             set_led_2(!led_state);
             last_blink = HAL_GetTick();
         }
-        HAL_Delay(10);
+        // Sleep instead of spinning, I2C2 still wakes us early. The ADV7511 pin has no interrupt
+        // here and waits for the next pass.
+        __disable_irq();
+        idle_sleep(10);
+        __enable_irq();
+        smbus_slave_poll();
+        smbus_ram_poll();
 
         // ADV handling for VIC mode for emergency
+        adv7511_read_status(&encoder.status);
+        // No EXTI handler here, the pin is sampled once per pass instead
+        encoder.interrupt = adv_irq_asserted();
         adv_handle_interrupts(&encoder);
-        stand_alone_loop(&encoder, xb_encoder);
+        adv7511_commit_poll();
+        adv7511_power_poll(&encoder);
+        if (adv7511_ready(&encoder)) {
+            stand_alone_loop(&encoder, xb_encoder);
+
+            // Lets the application skip the encoder set up after the update
+            handoff_store(xb_encoder, encoder.vic & ADV7511_VIC_CHANGED_CLEAR, HANDOFF_INIT_DONE);
+        }
     }
 }
@@ -1,3 +1,5 @@
 #pragma once
 
+#include "../shared/smbus_slave.h"
+
 void smbus_i2c_init();
@@ -1,13 +1,91 @@
 #include "adv7511_i2c.h"
+#include "adv7511_minimal.h"
+#include "i2c_timing.h"
 #include "../shared/debug.h"
 
+#ifdef ADV7511_I2C_LL
+#include "adv7511_i2c_ll.h"
+#define ADV7511_I2C_DRIVER "LL"
+#else
+#define ADV7511_I2C_DRIVER "HAL"
+#endif
+
 static I2C_HandleTypeDef hi2c1;
+static uint32_t bus_speed_hz = 0;
 
-void adv7511_i2c_init()
-{
-    __HAL_RCC_GPIOB_CLK_ENABLE();
-    __HAL_RCC_I2C1_CLK_ENABLE();
+typedef enum {
+    ADV7511_I2C_OP_WRITE,
+    ADV7511_I2C_OP_READ,
+    ADV7511_I2C_OP_UPDATE  // Synchronous only, data holds mask and value
+} adv7511_i2c_op;
+
+typedef struct {
+    uint8_t op;
+    uint8_t dev_addr;
+    uint8_t reg;
+    uint8_t length;
+    uint8_t attempts;
+    uint8_t *buffer;
+    adv7511_i2c_callback callback;
+    void *context;
+    uint8_t inline_data[ADV7511_I2C_INLINE_SIZE];
+} adv7511_i2c_request;
+
+static adv7511_i2c_request queue[ADV7511_I2C_QUEUE_DEPTH];
+static volatile uint8_t queue_head = 0;  // Oldest request, in flight when queue_active is set
+static volatile uint8_t queue_tail = 0;
+static volatile bool queue_active = false;
+static volatile bool queue_held = false;
+static volatile uint32_t queue_started = 0;       // Tick the transfer in flight was started at
+static volatile bool recovery_pending = false;    // Set from the interrupt, the bus is cleared from thread context
+
+static adv7511_i2c_stats stats;
+
+static bool queue_start(adv7511_i2c_request *req);
+static void queue_complete(const bool ok);
+static HAL_StatusTypeDef i2c_attempt(const adv7511_i2c_op op, const uint8_t dev_addr, const uint8_t reg, uint8_t *data, const uint8_t length);
+
+#ifdef ADV7511_I2C_BENCHMARK
+typedef struct {
+    uint32_t transfers;
+    uint32_t bytes;
+    uint32_t cycles;
+    uint32_t max_cycles;
+} adv7511_i2c_bench;
 
+static adv7511_i2c_bench bench_sync;
+static adv7511_i2c_bench bench_async;  // Submitting plus the interrupts, max is the longest single one
+
+// Running CPU cycle count, SysTick counts down from LOAD once per tick
+static uint32_t bench_cycles() {
+    uint32_t tick, val;
+    do {
+        tick = HAL_GetTick();
+        val = SysTick->VAL;
+    } while (tick != HAL_GetTick());
+    return tick * (SysTick->LOAD + 1) + (SysTick->LOAD - val);
+}
+
+static void bench_record(adv7511_i2c_bench *bench, const uint32_t cycles, const uint8_t length) {
+    if (length) {
+        bench->transfers++;
+        bench->bytes += length;
+    }
+    bench->cycles += cycles;
+    if (cycles > bench->max_cycles) {
+        bench->max_cycles = cycles;
+    }
+}
+
+#define BENCH_START()             const uint32_t bench_start = bench_cycles()
+#define BENCH_STOP(bench, length) bench_record(&(bench), bench_cycles() - bench_start, (length))
+#else
+#define BENCH_START()             ((void)0)
+#define BENCH_STOP(bench, length) ((void)0)
+#endif
+
+static void adv7511_i2c_pins()
+{
     // Configure PB6 (SCL) and PB7 (SDA) as I2C pins
     GPIO_InitTypeDef GPIO_InitStruct = {0};
     GPIO_InitStruct.Pin = GPIO_PIN_6 | GPIO_PIN_7;
@@ -16,9 +94,14 @@ void adv7511_i2c_init()
     GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_HIGH;
     GPIO_InitStruct.Alternate = GPIO_AF1_I2C1;
     HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+}
+
+static bool adv7511_i2c_configure(const uint32_t speed_hz)
+{
+    bus_speed_hz = speed_hz;
 
     hi2c1.Instance = I2C1;
-    hi2c1.Init.Timing = 0x00303D5B; // 100kHz for 48MHz APB1 — check your actual clock
+    hi2c1.Init.Timing = i2c_timing(i2c_kernel_clock(I2C1), speed_hz);
     hi2c1.Init.OwnAddress1 = 0;
     hi2c1.Init.AddressingMode = I2C_ADDRESSINGMODE_7BIT;
     hi2c1.Init.DualAddressMode = I2C_DUALADDRESS_DISABLE;
@@ -29,23 +112,446 @@ void adv7511_i2c_init()
     if (HAL_I2C_Init(&hi2c1) != HAL_OK)
     {
         debug_log("ADV7511 I2C init failed\n");
-        while(1);
+        return false;
     }
 
     if (HAL_I2CEx_ConfigAnalogFilter(&hi2c1, I2C_ANALOGFILTER_ENABLE) != HAL_OK)
     {
         debug_log("ADV7511 I2C onfig analog filter failed\\n");
-        while(1);
+        return false;
     }
 
     if (HAL_I2CEx_ConfigDigitalFilter(&hi2c1, 0) != HAL_OK)
     {
         debug_log("ADV7511 I2C config digital filter failed\n");
-        while(1);
+        return false;
+    }
+
+#ifdef I2C_FASTMODEPLUS_PB6
+    // Fast mode plus needs the stronger drive on the pins
+    if (speed_hz > I2C_SPEED_FAST) {
+        HAL_I2CEx_EnableFastModePlus(I2C_FASTMODEPLUS_PB6);
+        HAL_I2CEx_EnableFastModePlus(I2C_FASTMODEPLUS_PB7);
+    } else {
+        HAL_I2CEx_DisableFastModePlus(I2C_FASTMODEPLUS_PB6);
+        HAL_I2CEx_DisableFastModePlus(I2C_FASTMODEPLUS_PB7);
+    }
+#endif
+
+    return true;
+}
+
+// At least 5us, half a standard mode SCL period
+static void bus_delay()
+{
+    for (volatile uint32_t i = SystemCoreClock / 1000000; i > 0; i--) {}
+}
+
+// A slave reset or glitched mid byte can hold SDA low forever. Clock SCL until it lets go
+// (at most 9 clocks finish any byte plus its ACK), then leave a STOP on the bus.
+static void bus_clear()
+{
+    HAL_GPIO_WritePin(GPIOB, GPIO_PIN_6 | GPIO_PIN_7, GPIO_PIN_SET);
+
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+    GPIO_InitStruct.Pin = GPIO_PIN_6 | GPIO_PIN_7;
+    GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_OD;
+    GPIO_InitStruct.Pull = GPIO_PULLUP;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_HIGH;
+    HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+    bus_delay();
+
+    for (uint8_t i = 0; i < 9 && HAL_GPIO_ReadPin(GPIOB, GPIO_PIN_7) == GPIO_PIN_RESET; i++) {
+        HAL_GPIO_WritePin(GPIOB, GPIO_PIN_6, GPIO_PIN_RESET);
+        bus_delay();
+        HAL_GPIO_WritePin(GPIOB, GPIO_PIN_6, GPIO_PIN_SET);
+        bus_delay();
+    }
+
+    // SDA rising while SCL is high
+    HAL_GPIO_WritePin(GPIOB, GPIO_PIN_6, GPIO_PIN_RESET);
+    bus_delay();
+    HAL_GPIO_WritePin(GPIOB, GPIO_PIN_7, GPIO_PIN_RESET);
+    bus_delay();
+    HAL_GPIO_WritePin(GPIOB, GPIO_PIN_6, GPIO_PIN_SET);
+    bus_delay();
+    HAL_GPIO_WritePin(GPIOB, GPIO_PIN_7, GPIO_PIN_SET);
+    bus_delay();
+}
+
+// Clears the bus and brings the peripheral back from scratch, any transfer in flight is lost.
+// Must be called from thread context with the I2C1 interrupt masked.
+static void adv7511_i2c_recover()
+{
+    debug_log("ADV7511 I2C bus recovery\r\n");
+    stats.recoveries++;
+    recovery_pending = false;
+
+    HAL_I2C_DeInit(&hi2c1);
+    bus_clear();
+    adv7511_i2c_pins();
+    if (!adv7511_i2c_configure(bus_speed_hz)) {
+        recovery_pending = true;
+    }
+    HAL_NVIC_ClearPendingIRQ(I2C1_IRQn);
+}
+
+// Reads back the revision register a few times, a flaky bus shows up as errors or mismatches
+static bool adv7511_i2c_probe()
+{
+    uint8_t errors = 0;
+    uint8_t first = 0;
+
+    for (uint8_t i = 0; i < ADV7511_I2C_PROBE_READS; i++) {
+        uint8_t revision = 0;
+        if (i2c_attempt(ADV7511_I2C_OP_READ, ADV7511_MAIN_I2C_ADDR, 0x00, &revision, 1) != HAL_OK) {
+            errors++;
+        } else if (i == 0) {
+            first = revision;
+        } else if (revision != first) {
+            errors++;
+        }
+    }
+
+    return errors <= ADV7511_I2C_PROBE_MAX_ERRORS;
+}
+
+void adv7511_i2c_init()
+{
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+    __HAL_RCC_I2C1_CLK_ENABLE();
+
+    adv7511_i2c_pins();
+
+    // Start at the configured speed and step down while the encoder doesn't answer reliably.
+    // Standard mode is kept even if it fails too, there is nothing slower to try.
+    static const uint32_t speeds[] = {I2C_SPEED_FAST_PLUS, I2C_SPEED_FAST, I2C_SPEED_STANDARD};
+    for (uint8_t i = 0; i < sizeof(speeds) / sizeof(speeds[0]); i++) {
+        if (speeds[i] > ADV7511_I2C_SPEED_HZ) {
+            continue;
+        }
+
+        if (adv7511_i2c_configure(speeds[i]) && adv7511_i2c_probe()) {
+            recovery_pending = false;
+            break;
+        }
+        debug_log("ADV7511 I2C unreliable at %lu Hz\r\n", (unsigned long)speeds[i]);
+
+        // Try to get the bus back before the next speed, and again later if it is still stuck
+        HAL_I2C_DeInit(&hi2c1);
+        bus_clear();
+        adv7511_i2c_pins();
+        recovery_pending = true;
     }
+
+    HAL_NVIC_SetPriority(I2C1_IRQn, 2, 0);
+    HAL_NVIC_EnableIRQ(I2C1_IRQn);
+}
+
+uint32_t adv7511_i2c_speed()
+{
+    return bus_speed_hz;
 }
 
 I2C_HandleTypeDef* adv7511_i2c_instance()
 {
     return &hi2c1;
 }
+
+const adv7511_i2c_stats* adv7511_i2c_get_stats()
+{
+    return &stats;
+}
+
+static inline uint8_t queue_next(const uint8_t index) {
+    return (index + 1) % ADV7511_I2C_QUEUE_DEPTH;
+}
+
+// Must be called with the I2C1 interrupt masked or from within it
+static void queue_kick() {
+    while (!queue_held && !queue_active && queue_head != queue_tail) {
+        queue_active = true;
+        queue_started = HAL_GetTick();
+        if (!queue_start(&queue[queue_head])) {
+            queue_complete(false);
+        }
+    }
+}
+
+#ifdef ADV7511_I2C_LL
+static void queue_ll_done(const bool ok) {
+    queue_complete(ok);
+    queue_kick();
+}
+
+static bool queue_start(adv7511_i2c_request *req) {
+    if (req->op == ADV7511_I2C_OP_WRITE) {
+        return adv7511_i2c_ll_start_write(req->dev_addr, req->reg, req->buffer, req->length, queue_ll_done);
+    }
+    return adv7511_i2c_ll_start_read(req->dev_addr, req->reg, req->buffer, req->length, queue_ll_done);
+}
+#else
+static bool queue_start(adv7511_i2c_request *req) {
+    if (req->op == ADV7511_I2C_OP_WRITE) {
+        return HAL_I2C_Mem_Write_IT(&hi2c1, req->dev_addr, req->reg, I2C_MEMADD_SIZE_8BIT, req->buffer, req->length) == HAL_OK;
+    }
+    return HAL_I2C_Mem_Read_IT(&hi2c1, req->dev_addr, req->reg, I2C_MEMADD_SIZE_8BIT, req->buffer, req->length) == HAL_OK;
+}
+#endif
+
+// Deadline for the transfer in flight and the deferred bus recovery. Runs from the loops
+// waiting on the queue, clocking the bus by hand is too slow for the interrupt.
+static void queue_watchdog() {
+    const bool expired = queue_active && (HAL_GetTick() - queue_started) > ADV7511_I2C_TIMEOUT_MS;
+    if (!expired && !(recovery_pending && !queue_active)) {
+        return;
+    }
+
+    HAL_NVIC_DisableIRQ(I2C1_IRQn);
+    if (queue_active && (HAL_GetTick() - queue_started) > ADV7511_I2C_TIMEOUT_MS) {
+        stats.timeouts++;
+        adv7511_i2c_recover();
+        queue_complete(false);
+        queue_kick();
+    } else if (recovery_pending && !queue_active) {
+        adv7511_i2c_recover();
+        queue_kick();
+    }
+    HAL_NVIC_EnableIRQ(I2C1_IRQn);
+}
+
+static void queue_complete(const bool ok) {
+    adv7511_i2c_request *req = &queue[queue_head];
+
+    if (!ok) {
+        stats.errors++;
+
+        // After a NACK the automatic STOP may still be going out, only a bus that stays busy
+        // past that (20 waits of at least 5us, a STOP takes one SCL period) is stuck
+        for (uint8_t i = 0; i < 20 && (I2C1->ISR & I2C_ISR_BUSY); i++) {
+            bus_delay();
+        }
+        if (I2C1->ISR & I2C_ISR_BUSY) {
+            recovery_pending = true;
+        }
+
+        // Leave it at the head so queue_kick() starts it again
+        if (req->attempts < ADV7511_I2C_RETRIES) {
+            req->attempts++;
+            stats.retries++;
+            queue_active = false;
+            return;
+        }
+    }
+
+    adv7511_i2c_callback callback = req->callback;
+    void *context = req->context;
+
+    queue_head = queue_next(queue_head);
+    queue_active = false;
+
+    if (callback) {
+        callback(ok, context);
+    }
+}
+
+static bool queue_submit(const adv7511_i2c_op op, const uint8_t dev_addr, const uint8_t reg, uint8_t *data, const uint8_t length, adv7511_i2c_callback callback, void *context) {
+    if (length == 0) {
+        return false;
+    }
+
+    // Wait for a free slot, the interrupt keeps draining the queue meanwhile.
+    // A held queue never drains, let the staged transfers go rather than deadlock.
+    if (queue_held && queue_next(queue_tail) == queue_head) {
+        debug_log("ADV7511 I2C queue full while held\r\n");
+        adv7511_i2c_release();
+    }
+    while (queue_next(queue_tail) == queue_head) {
+        queue_watchdog();
+    }
+
+    // Only the I2C1 interrupt touches the queue, leave SysTick and the SMBus running
+    HAL_NVIC_DisableIRQ(I2C1_IRQn);
+    BENCH_START();
+
+    adv7511_i2c_request *req = &queue[queue_tail];
+    req->op = op;
+    req->dev_addr = dev_addr;
+    req->reg = reg;
+    req->length = length;
+    req->attempts = 0;
+    req->callback = callback;
+    req->context = context;
+
+    if (op == ADV7511_I2C_OP_WRITE && length <= ADV7511_I2C_INLINE_SIZE) {
+        for (uint8_t i = 0; i < length; i++) {
+            req->inline_data[i] = data[i];
+        }
+        req->buffer = req->inline_data;
+    } else {
+        req->buffer = data;
+    }
+
+    queue_tail = queue_next(queue_tail);
+    queue_kick();
+
+    BENCH_STOP(bench_async, length);
+    HAL_NVIC_EnableIRQ(I2C1_IRQn);
+    return true;
+}
+
+bool adv7511_i2c_write_async(const uint8_t dev_addr, const uint8_t reg, const uint8_t *data, const uint8_t length, adv7511_i2c_callback callback, void *context) {
+    return queue_submit(ADV7511_I2C_OP_WRITE, dev_addr, reg, (uint8_t *)data, length, callback, context);
+}
+
+bool adv7511_i2c_read_async(const uint8_t dev_addr, const uint8_t reg, uint8_t *data, const uint8_t length, adv7511_i2c_callback callback, void *context) {
+    return queue_submit(ADV7511_I2C_OP_READ, dev_addr, reg, data, length, callback, context);
+}
+
+bool adv7511_i2c_busy() {
+    return queue_active || (!queue_held && queue_head != queue_tail);
+}
+
+void adv7511_i2c_hold() {
+    queue_held = true;
+}
+
+void adv7511_i2c_release() {
+    HAL_NVIC_DisableIRQ(I2C1_IRQn);
+    queue_held = false;
+    queue_kick();
+    HAL_NVIC_EnableIRQ(I2C1_IRQn);
+}
+
+void adv7511_i2c_flush() {
+    queue_watchdog();
+    while (adv7511_i2c_busy()) {
+        queue_watchdog();
+    }
+}
+
+// One attempt on the bus, bounded by ADV7511_I2C_TIMEOUT_MS
+static HAL_StatusTypeDef i2c_attempt(const adv7511_i2c_op op, const uint8_t dev_addr, const uint8_t reg, uint8_t *data, const uint8_t length) {
+    HAL_StatusTypeDef status;
+    BENCH_START();
+#ifdef ADV7511_I2C_LL
+    if (op == ADV7511_I2C_OP_WRITE) {
+        status = adv7511_i2c_ll_write(dev_addr, reg, data, length, ADV7511_I2C_TIMEOUT_MS);
+    } else if (op == ADV7511_I2C_OP_READ) {
+        status = adv7511_i2c_ll_read(dev_addr, reg, data, length, ADV7511_I2C_TIMEOUT_MS);
+    } else {
+        status = adv7511_i2c_ll_update(dev_addr, reg, data[0], data[1], ADV7511_I2C_TIMEOUT_MS);
+    }
+#else
+    if (op == ADV7511_I2C_OP_WRITE) {
+        status = HAL_I2C_Mem_Write(&hi2c1, dev_addr, reg, I2C_MEMADD_SIZE_8BIT, data, length, ADV7511_I2C_TIMEOUT_MS);
+    } else if (op == ADV7511_I2C_OP_READ) {
+        status = HAL_I2C_Mem_Read(&hi2c1, dev_addr, reg, I2C_MEMADD_SIZE_8BIT, data, length, ADV7511_I2C_TIMEOUT_MS);
+    } else {
+        uint8_t current = 0;
+        status = HAL_I2C_Mem_Read(&hi2c1, dev_addr, reg, I2C_MEMADD_SIZE_8BIT, &current, 1, ADV7511_I2C_TIMEOUT_MS);
+        if (status == HAL_OK) {
+            current = (current & ~data[0]) | (data[1] & data[0]);
+            status = HAL_I2C_Mem_Write(&hi2c1, dev_addr, reg, I2C_MEMADD_SIZE_8BIT, &current, 1, ADV7511_I2C_TIMEOUT_MS);
+        }
+    }
+#endif
+    BENCH_STOP(bench_sync, length);
+    return status;
+}
+
+static HAL_StatusTypeDef i2c_sync(const adv7511_i2c_op op, const uint8_t dev_addr, const uint8_t reg, uint8_t *data, const uint8_t length) {
+    adv7511_i2c_flush();
+
+    HAL_StatusTypeDef status = HAL_ERROR;
+    for (uint8_t attempt = 0; attempt <= ADV7511_I2C_RETRIES; attempt++) {
+        if (attempt > 0) {
+            stats.retries++;
+        }
+
+        status = i2c_attempt(op, dev_addr, reg, data, length);
+        if (status == HAL_OK) {
+            break;
+        }
+
+        if (status == HAL_TIMEOUT || status == HAL_BUSY) {
+            stats.timeouts++;
+        } else {
+            stats.errors++;
+        }
+
+        // A NACK leaves the bus free, anything else may have left it stuck
+        if (status != HAL_ERROR || (I2C1->ISR & I2C_ISR_BUSY)) {
+            HAL_NVIC_DisableIRQ(I2C1_IRQn);
+            adv7511_i2c_recover();
+            HAL_NVIC_EnableIRQ(I2C1_IRQn);
+        }
+    }
+    return status;
+}
+
+HAL_StatusTypeDef adv7511_i2c_write(const uint8_t dev_addr, const uint8_t reg, const uint8_t *data, const uint8_t length) {
+    return i2c_sync(ADV7511_I2C_OP_WRITE, dev_addr, reg, (uint8_t *)data, length);
+}
+
+HAL_StatusTypeDef adv7511_i2c_read(const uint8_t dev_addr, const uint8_t reg, uint8_t *data, const uint8_t length) {
+    return i2c_sync(ADV7511_I2C_OP_READ, dev_addr, reg, data, length);
+}
+
+HAL_StatusTypeDef adv7511_i2c_update(const uint8_t dev_addr, const uint8_t reg, const uint8_t mask, const uint8_t value) {
+    uint8_t data[] = {mask, value};
+    return i2c_sync(ADV7511_I2C_OP_UPDATE, dev_addr, reg, data, 1);
+}
+
+#ifdef ADV7511_I2C_BENCHMARK
+void adv7511_i2c_benchmark_report() {
+    const adv7511_i2c_bench *benches[] = {&bench_sync, &bench_async};
+    const char *names[] = {"sync", "async"};
+
+    for (uint8_t i = 0; i < 2; i++) {
+        const adv7511_i2c_bench *bench = benches[i];
+        debug_log("ADV7511 I2C %s %s: %lu transfers, %lu bytes, %lu cycles/transfer, max %lu\r\n",
+                  ADV7511_I2C_DRIVER, names[i],
+                  (unsigned long)bench->transfers, (unsigned long)bench->bytes,
+                  (unsigned long)(bench->transfers ? bench->cycles / bench->transfers : 0),
+                  (unsigned long)bench->max_cycles);
+    }
+}
+#endif
+
+#ifndef ADV7511_I2C_LL
+// -------------------- HAL Callbacks --------------------
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c) {
+    if (hi2c->Instance != I2C1 || !queue_active) return;
+    queue_complete(true);
+    queue_kick();
+}
+
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c) {
+    if (hi2c->Instance != I2C1 || !queue_active) return;
+    queue_complete(true);
+    queue_kick();
+}
+#endif
+
+// HAL_I2C_ErrorCallback is owned by the SMBus slave, it forwards I2C1 errors here
+void adv7511_i2c_error(I2C_HandleTypeDef *hi2c) {
+    if (!queue_active) return;
+    queue_complete(false);
+    queue_kick();
+}
+
+// -------------------- IRQ Handler --------------------
+void I2C1_IRQHandler(void) {
+    BENCH_START();
+#ifdef ADV7511_I2C_LL
+    adv7511_i2c_ll_irq();
+#else
+    if (hi2c1.Instance->ISR & (I2C_FLAG_BERR | I2C_FLAG_ARLO | I2C_FLAG_OVR | I2C_FLAG_TIMEOUT | I2C_FLAG_ALERT | I2C_FLAG_PECERR)) {
+        HAL_I2C_ER_IRQHandler(&hi2c1);
+    } else {
+        HAL_I2C_EV_IRQHandler(&hi2c1);
+    }
+#endif
+    BENCH_STOP(bench_async, 0);
+}
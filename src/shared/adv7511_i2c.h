@@ -2,8 +2,63 @@
 #define __ADV7511_I2C_H__
 
 #include "stm32.h"
+#include "i2c_timing.h"
+#include <stdbool.h>
+
+// ADV7511 bus speed, I2C_SPEED_STANDARD, I2C_SPEED_FAST or I2C_SPEED_FAST_PLUS
+#ifndef ADV7511_I2C_SPEED_HZ
+#define ADV7511_I2C_SPEED_HZ I2C_SPEED_FAST
+#endif
+// Init steps down to the next slower speed if more than this many of the probe reads fail
+#define ADV7511_I2C_PROBE_READS 8
+#define ADV7511_I2C_PROBE_MAX_ERRORS 1
+
+// Pending transfers on the ADV7511 bus, serviced from the I2C1 interrupt
+#define ADV7511_I2C_QUEUE_DEPTH 16
+// Deadline for a single transfer, a stuck bus is recovered once it passed
+#define ADV7511_I2C_TIMEOUT_MS 25
+// Failed transfers are tried this many more times before giving up
+#define ADV7511_I2C_RETRIES 2
+// Writes up to this size are copied into the queue, longer ones must keep their buffer alive
+#define ADV7511_I2C_INLINE_SIZE 6
+
+// Called from interrupt context once a queued transfer finished
+typedef void (*adv7511_i2c_callback)(const bool ok, void *context);
+
+typedef struct {
+    uint16_t errors;      // Failed attempts, NACKs included
+    uint16_t timeouts;    // Attempts that ran past ADV7511_I2C_TIMEOUT_MS
+    uint16_t retries;
+    uint16_t recoveries;  // Bus cleared and peripheral brought back up
+} adv7511_i2c_stats;
 
 void adv7511_i2c_init();
 I2C_HandleTypeDef* adv7511_i2c_instance();
+// Bus speed settled on by adv7511_i2c_init()
+uint32_t adv7511_i2c_speed();
+const adv7511_i2c_stats* adv7511_i2c_get_stats();
+
+// Asynchronous interface, returns false if the transfer could not be queued
+bool adv7511_i2c_write_async(const uint8_t dev_addr, const uint8_t reg, const uint8_t *data, const uint8_t length, adv7511_i2c_callback callback, void *context);
+bool adv7511_i2c_read_async(const uint8_t dev_addr, const uint8_t reg, uint8_t *data, const uint8_t length, adv7511_i2c_callback callback, void *context);
+bool adv7511_i2c_busy();
+void adv7511_i2c_flush();
+
+// While held, queued transfers are kept back until adv7511_i2c_release(). Synchronous
+// transfers still go straight to the bus, so status can be polled in the meantime.
+void adv7511_i2c_hold();
+void adv7511_i2c_release();
+
+// Synchronous interface, drains the queue first so ordering is kept
+HAL_StatusTypeDef adv7511_i2c_write(const uint8_t dev_addr, const uint8_t reg, const uint8_t *data, const uint8_t length);
+HAL_StatusTypeDef adv7511_i2c_read(const uint8_t dev_addr, const uint8_t reg, uint8_t *data, const uint8_t length);
+HAL_StatusTypeDef adv7511_i2c_update(const uint8_t dev_addr, const uint8_t reg, const uint8_t mask, const uint8_t value);
+
+#ifdef ADV7511_I2C_BENCHMARK
+// Logs the CPU cycles spent per transfer by the selected driver
+void adv7511_i2c_benchmark_report();
+#endif
+
+void adv7511_i2c_error(I2C_HandleTypeDef *hi2c);
 
 #endif // __ADV7511_I2C_H__
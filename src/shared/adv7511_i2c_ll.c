@@ -0,0 +1,223 @@
+#include "adv7511_i2c_ll.h"
+
+#define LL_I2C_INTERRUPTS (I2C_CR1_TXIE | I2C_CR1_RXIE | I2C_CR1_TCIE | I2C_CR1_STOPIE | I2C_CR1_NACKIE | I2C_CR1_ERRIE)
+#define LL_I2C_ERRORS     (I2C_ISR_BERR | I2C_ISR_ARLO | I2C_ISR_OVR)
+
+// The interrupt driven transfer in flight
+static struct {
+    uint8_t dev_addr;
+    uint8_t reg;
+    uint8_t *data;
+    uint8_t length;
+    uint8_t index;
+    bool reg_sent;
+    bool ok;
+    adv7511_i2c_ll_done done;
+} xfer;
+
+// -------------------- Blocking --------------------
+static HAL_StatusTypeDef ll_wait(const uint32_t flag, const uint32_t start, const uint32_t timeout_ms) {
+    while (!(I2C1->ISR & flag)) {
+        if (I2C1->ISR & (I2C_ISR_NACKF | LL_I2C_ERRORS)) {
+            return HAL_ERROR;
+        }
+        if ((HAL_GetTick() - start) > timeout_ms) {
+            return HAL_TIMEOUT;
+        }
+    }
+    return HAL_OK;
+}
+
+static HAL_StatusTypeDef ll_start(const uint32_t start, const uint32_t timeout_ms) {
+    while (I2C1->ISR & I2C_ISR_BUSY) {
+        if ((HAL_GetTick() - start) > timeout_ms) {
+            return HAL_BUSY;
+        }
+    }
+    return HAL_OK;
+}
+
+// Ends the transfer with a STOP, on failure the STOP may not have been queued by AUTOEND
+static HAL_StatusTypeDef ll_finish(HAL_StatusTypeDef status, const uint32_t start, const uint32_t timeout_ms) {
+    if (status != HAL_OK && (I2C1->ISR & I2C_ISR_BUSY)) {
+        LL_I2C_GenerateStopCondition(I2C1);
+    }
+
+    while ((I2C1->ISR & I2C_ISR_BUSY) && !(I2C1->ISR & I2C_ISR_STOPF)) {
+        if ((HAL_GetTick() - start) > timeout_ms) {
+            status = HAL_TIMEOUT;
+            break;
+        }
+    }
+
+    I2C1->ICR = I2C_ICR_STOPCF | I2C_ICR_NACKCF | I2C_ICR_BERRCF | I2C_ICR_ARLOCF | I2C_ICR_OVRCF;
+    I2C1->CR2 = 0;
+    return status;
+}
+
+HAL_StatusTypeDef adv7511_i2c_ll_write(const uint8_t dev_addr, const uint8_t reg, const uint8_t *data, const uint8_t length, const uint32_t timeout_ms) {
+    // NBYTES also carries the register address
+    if (length == 0 || length == 0xFF) {
+        return HAL_ERROR;
+    }
+
+    const uint32_t start = HAL_GetTick();
+    HAL_StatusTypeDef status = ll_start(start, timeout_ms);
+    if (status != HAL_OK) {
+        return status;
+    }
+
+    LL_I2C_HandleTransfer(I2C1, dev_addr, LL_I2C_ADDRSLAVE_7BIT, length + 1, LL_I2C_MODE_AUTOEND, LL_I2C_GENERATE_START_WRITE);
+
+    status = ll_wait(I2C_ISR_TXIS, start, timeout_ms);
+    if (status == HAL_OK) {
+        LL_I2C_TransmitData8(I2C1, reg);
+    }
+
+    for (uint8_t i = 0; i < length && status == HAL_OK; i++) {
+        status = ll_wait(I2C_ISR_TXIS, start, timeout_ms);
+        if (status == HAL_OK) {
+            LL_I2C_TransmitData8(I2C1, data[i]);
+        }
+    }
+
+    return ll_finish(status, start, timeout_ms);
+}
+
+HAL_StatusTypeDef adv7511_i2c_ll_read(const uint8_t dev_addr, const uint8_t reg, uint8_t *data, const uint8_t length, const uint32_t timeout_ms) {
+    if (length == 0) {
+        return HAL_ERROR;
+    }
+
+    const uint32_t start = HAL_GetTick();
+    HAL_StatusTypeDef status = ll_start(start, timeout_ms);
+    if (status != HAL_OK) {
+        return status;
+    }
+
+    // Register address without a STOP, then a repeated START for the read
+    LL_I2C_HandleTransfer(I2C1, dev_addr, LL_I2C_ADDRSLAVE_7BIT, 1, LL_I2C_MODE_SOFTEND, LL_I2C_GENERATE_START_WRITE);
+
+    status = ll_wait(I2C_ISR_TXIS, start, timeout_ms);
+    if (status == HAL_OK) {
+        LL_I2C_TransmitData8(I2C1, reg);
+        status = ll_wait(I2C_ISR_TC, start, timeout_ms);
+    }
+
+    if (status == HAL_OK) {
+        LL_I2C_HandleTransfer(I2C1, dev_addr, LL_I2C_ADDRSLAVE_7BIT, length, LL_I2C_MODE_AUTOEND, LL_I2C_GENERATE_START_READ);
+    }
+
+    for (uint8_t i = 0; i < length && status == HAL_OK; i++) {
+        status = ll_wait(I2C_ISR_RXNE, start, timeout_ms);
+        if (status == HAL_OK) {
+            data[i] = LL_I2C_ReceiveData8(I2C1);
+        }
+    }
+
+    return ll_finish(status, start, timeout_ms);
+}
+
+HAL_StatusTypeDef adv7511_i2c_ll_update(const uint8_t dev_addr, const uint8_t reg, const uint8_t mask, const uint8_t value, const uint32_t timeout_ms) {
+    uint8_t current = 0;
+    HAL_StatusTypeDef status = adv7511_i2c_ll_read(dev_addr, reg, &current, 1, timeout_ms);
+    if (status != HAL_OK) {
+        return status;
+    }
+
+    const uint8_t updated = (current & ~mask) | (value & mask);
+    return adv7511_i2c_ll_write(dev_addr, reg, &updated, 1, timeout_ms);
+}
+
+// -------------------- Interrupt driven --------------------
+static bool ll_start_it(const uint8_t dev_addr, const uint8_t reg, uint8_t *data, const uint8_t length, adv7511_i2c_ll_done done) {
+    if (I2C1->ISR & I2C_ISR_BUSY) {
+        return false;
+    }
+
+    xfer.dev_addr = dev_addr;
+    xfer.reg = reg;
+    xfer.data = data;
+    xfer.length = length;
+    xfer.index = 0;
+    xfer.reg_sent = false;
+    xfer.ok = true;
+    xfer.done = done;
+
+    I2C1->ICR = I2C_ICR_STOPCF | I2C_ICR_NACKCF | I2C_ICR_BERRCF | I2C_ICR_ARLOCF | I2C_ICR_OVRCF;
+    I2C1->CR1 |= LL_I2C_INTERRUPTS;
+    return true;
+}
+
+bool adv7511_i2c_ll_start_write(const uint8_t dev_addr, const uint8_t reg, const uint8_t *data, const uint8_t length, adv7511_i2c_ll_done done) {
+    if (length == 0 || length == 0xFF || !ll_start_it(dev_addr, reg, (uint8_t *)data, length, done)) {
+        return false;
+    }
+    LL_I2C_HandleTransfer(I2C1, dev_addr, LL_I2C_ADDRSLAVE_7BIT, length + 1, LL_I2C_MODE_AUTOEND, LL_I2C_GENERATE_START_WRITE);
+    return true;
+}
+
+bool adv7511_i2c_ll_start_read(const uint8_t dev_addr, const uint8_t reg, uint8_t *data, const uint8_t length, adv7511_i2c_ll_done done) {
+    if (length == 0 || !ll_start_it(dev_addr, reg, data, length, done)) {
+        return false;
+    }
+    LL_I2C_HandleTransfer(I2C1, dev_addr, LL_I2C_ADDRSLAVE_7BIT, 1, LL_I2C_MODE_SOFTEND, LL_I2C_GENERATE_START_WRITE);
+    return true;
+}
+
+static void ll_complete() {
+    I2C1->CR1 &= ~LL_I2C_INTERRUPTS;
+    I2C1->CR2 = 0;
+
+    adv7511_i2c_ll_done done = xfer.done;
+    xfer.done = NULL;
+    if (done) {
+        done(xfer.ok);
+    }
+}
+
+void adv7511_i2c_ll_irq() {
+    const uint32_t isr = I2C1->ISR;
+
+    // Bus errors and lost arbitration release the bus without a STOP
+    if (isr & LL_I2C_ERRORS) {
+        I2C1->ICR = I2C_ICR_BERRCF | I2C_ICR_ARLOCF | I2C_ICR_OVRCF;
+        xfer.ok = false;
+        ll_complete();
+        return;
+    }
+
+    if (isr & I2C_ISR_NACKF) {
+        I2C1->ICR = I2C_ICR_NACKCF;
+        xfer.ok = false;
+        if (!(I2C1->CR2 & I2C_CR2_AUTOEND)) {
+            LL_I2C_GenerateStopCondition(I2C1);
+        }
+    }
+
+    if (isr & I2C_ISR_TXIS) {
+        if (!xfer.reg_sent) {
+            LL_I2C_TransmitData8(I2C1, xfer.reg);
+            xfer.reg_sent = true;
+        } else if (xfer.index < xfer.length) {
+            LL_I2C_TransmitData8(I2C1, xfer.data[xfer.index++]);
+        }
+    }
+
+    if (isr & I2C_ISR_RXNE) {
+        const uint8_t data = LL_I2C_ReceiveData8(I2C1);
+        if (xfer.index < xfer.length) {
+            xfer.data[xfer.index++] = data;
+        }
+    }
+
+    // Only reads run in software end mode, the register address went out so restart as a read
+    if (isr & I2C_ISR_TC) {
+        LL_I2C_HandleTransfer(I2C1, xfer.dev_addr, LL_I2C_ADDRSLAVE_7BIT, xfer.length, LL_I2C_MODE_AUTOEND, LL_I2C_GENERATE_START_READ);
+    }
+
+    if (isr & I2C_ISR_STOPF) {
+        I2C1->ICR = I2C_ICR_STOPCF;
+        ll_complete();
+    }
+}
@@ -0,0 +1,23 @@
+#ifndef __ADV7511_I2C_LL_H__
+#define __ADV7511_I2C_LL_H__
+
+#include "stm32.h"
+#include <stdbool.h>
+
+// Register level I2C1 master, used in place of the HAL transfers when ADV7511_I2C_LL is defined.
+// The peripheral itself is still set up by HAL_I2C_Init in adv7511_i2c_init().
+
+// Called from the I2C1 interrupt once an interrupt driven transfer finished
+typedef void (*adv7511_i2c_ll_done)(const bool ok);
+
+// Blocking transfers, every wait on the bus is bounded by timeout_ms
+HAL_StatusTypeDef adv7511_i2c_ll_write(const uint8_t dev_addr, const uint8_t reg, const uint8_t *data, const uint8_t length, const uint32_t timeout_ms);
+HAL_StatusTypeDef adv7511_i2c_ll_read(const uint8_t dev_addr, const uint8_t reg, uint8_t *data, const uint8_t length, const uint32_t timeout_ms);
+HAL_StatusTypeDef adv7511_i2c_ll_update(const uint8_t dev_addr, const uint8_t reg, const uint8_t mask, const uint8_t value, const uint32_t timeout_ms);
+
+// Interrupt driven transfers, data has to stay valid until done is called
+bool adv7511_i2c_ll_start_write(const uint8_t dev_addr, const uint8_t reg, const uint8_t *data, const uint8_t length, adv7511_i2c_ll_done done);
+bool adv7511_i2c_ll_start_read(const uint8_t dev_addr, const uint8_t reg, uint8_t *data, const uint8_t length, adv7511_i2c_ll_done done);
+void adv7511_i2c_ll_irq();
+
+#endif // __ADV7511_I2C_LL_H__
@@ -3,62 +3,441 @@
 
 #include "adv7511_minimal.h"
 #include "../shared/adv7511_i2c.h"
+#include "adv7511_regs.h"
+
+// Status and interrupt registers, these change under us and are never cached
+// 0x3D (VIC sent), 0x3E (VIC detected), 0x42 (HPD / monitor sense),
+// 0x96, 0x97 (interrupt status), 0x9E (PLL lock)
+static const uint8_t main_map_volatile[ADV7511_MAIN_MAP_SIZE / 8] = {
+    [0x3D / 8] = BIT(0x3D % 8) | BIT(0x3E % 8),
+    [0x42 / 8] = BIT(0x42 % 8),
+    [0x96 / 8] = BIT(0x96 % 8) | BIT(0x97 % 8),
+    [0x9E / 8] = BIT(0x9E % 8),
+};
+
+static uint8_t main_map_known[ADV7511_MAIN_MAP_SIZE / 8];
+static uint8_t main_map_value[ADV7511_MAIN_MAP_SIZE];
+
+static adv7511_regmap main_map = {
+    .i2c_addr = ADV7511_MAIN_I2C_ADDR,
+    .size = ADV7511_MAIN_MAP_SIZE,
+    .volatile_regs = main_map_volatile,
+    .known = main_map_known,
+    .value = main_map_value,
+};
+
+static inline bool regmap_test(const uint8_t *bitmap, const uint8_t address) {
+    return (bitmap[address >> 3] >> (address & 0x07)) & 0x01;
+}
+
+static inline bool regmap_cacheable(const adv7511_regmap *map, const uint8_t address) {
+    return address < map->size && !regmap_test(map->volatile_regs, address);
+}
+
+static inline void regmap_store(adv7511_regmap *map, const uint8_t address, const uint8_t value) {
+    map->value[address] = value;
+    map->known[address >> 3] |= (uint8_t)BIT(address & 0x07);
+}
+
+uint8_t adv7511_map_read(adv7511_regmap *map, const uint8_t address) {
+    const bool cacheable = regmap_cacheable(map, address);
+    if (cacheable && regmap_test(map->known, address)) {
+        return map->value[address];
+    }
 
-uint8_t adv7511_read_register(const uint8_t address) {
     uint8_t data = 0;
-    I2C_HandleTypeDef* hi2c = adv7511_i2c_instance();
-    HAL_I2C_Mem_Read(hi2c, ADV7511_MAIN_I2C_ADDR, address, I2C_MEMADD_SIZE_8BIT, &data, 1, HAL_MAX_DELAY);
+    if (adv7511_i2c_read(map->i2c_addr, address, &data, 1) == HAL_OK && cacheable) {
+        regmap_store(map, address, data);
+    }
     return data;
 }
 
+static void regmap_forget(adv7511_regmap *map, const uint8_t address, const uint8_t length) {
+    for (uint16_t reg = address; reg < (uint16_t)address + length && reg < map->size; reg++) {
+        map->known[reg >> 3] &= (uint8_t)~BIT(reg & 0x07);
+    }
+}
+
+// Registers carried by each queued write. One more than the I2C queue holds, so a slot is
+// never reused while its write can still complete.
+typedef struct {
+    adv7511_regmap *map;
+    uint8_t address;
+    uint8_t length;
+} regmap_posted;
+
+static regmap_posted posted[ADV7511_I2C_QUEUE_DEPTH + 1];
+static uint8_t posted_next = 0;
+
+// A failed write leaves only its own registers in an unknown state, read them back next time
+static void regmap_write_done(const bool ok, void *context) {
+    if (!ok) {
+        const regmap_posted *write = (const regmap_posted *)context;
+        regmap_forget(write->map, write->address, write->length);
+    }
+}
+
+// Writes are posted to the I2C queue, the shadow already holds the new value
+static void regmap_post(adv7511_regmap *map, const uint8_t address, const uint8_t *data, const uint8_t length) {
+    regmap_posted *write = &posted[posted_next];
+    posted_next = (posted_next + 1) % (sizeof(posted) / sizeof(posted[0]));
+    write->map = map;
+    write->address = address;
+    write->length = length;
+    if (!adv7511_i2c_write_async(map->i2c_addr, address, data, length, regmap_write_done, write)) {
+        regmap_forget(map, address, length);
+    }
+}
+
+void adv7511_map_write(adv7511_regmap *map, const uint8_t address, uint8_t value) {
+    if (regmap_cacheable(map, address)) {
+        regmap_store(map, address, value);
+    }
+    regmap_post(map, address, &value, 1);
+}
+
+void adv7511_map_update(adv7511_regmap *map, const uint8_t address, const uint8_t mask, uint8_t new_value) {
+    // Nothing to merge with in the shadow, read-modify-write on the bus in one go
+    if (!regmap_cacheable(map, address)) {
+        adv7511_i2c_update(map->i2c_addr, address, mask, new_value);
+        return;
+    }
+
+    const uint8_t current = adv7511_map_read(map, address);
+    uint8_t updated = (current & ~mask) | (new_value & mask);
+    adv7511_map_write(map, address, updated);
+}
+
+// Writes a run of registers in one transaction using the sub-address auto-increment.
+// Runs longer than ADV7511_I2C_INLINE_SIZE are sent straight from data, which has
+// to stay valid until the queue drained (const tables are fine).
+void adv7511_map_write_burst(adv7511_regmap *map, const uint8_t address, const uint8_t *data, const uint8_t length) {
+    for (uint8_t i = 0; i < length; i++) {
+        const uint8_t reg = address + i;
+        if (regmap_cacheable(map, reg)) {
+            regmap_store(map, reg, data[i]);
+        }
+    }
+    regmap_post(map, address, data, length);
+}
+
+// Reads a run of registers in one transaction, always from the bus. Only fills shadow entries
+// that aren't known yet, a known one may hold a write still waiting in the queue for VSYNC.
+void adv7511_map_read_burst(adv7511_regmap *map, const uint8_t address, uint8_t *data, const uint8_t length) {
+    if (adv7511_i2c_read(map->i2c_addr, address, data, length) != HAL_OK) {
+        for (uint8_t i = 0; i < length; i++) {
+            data[i] = 0;
+        }
+        return;
+    }
+
+    for (uint8_t i = 0; i < length; i++) {
+        const uint8_t reg = address + i;
+        if (regmap_cacheable(map, reg) && !regmap_test(map->known, reg)) {
+            regmap_store(map, reg, data[i]);
+        }
+    }
+}
+
+// Writes back every known register that no longer holds its shadowed value, e.g. after a power
+// cycle reset part of the map. Known registers are read back in runs, only differing runs are sent.
+void adv7511_map_replay(adv7511_regmap *map) {
+    uint16_t reg = 0;
+    while (reg < map->size) {
+        if (!regmap_cacheable(map, reg) || !regmap_test(map->known, reg)) {
+            reg++;
+            continue;
+        }
+
+        uint16_t end = reg;
+        while (end < map->size && (end - reg) < ADV7511_REPLAY_CHUNK && regmap_cacheable(map, end) && regmap_test(map->known, end)) {
+            end++;
+        }
+
+        uint8_t current[ADV7511_REPLAY_CHUNK];
+        const uint8_t length = end - reg;
+        if (adv7511_i2c_read(map->i2c_addr, reg, current, length) != HAL_OK) {
+            // Can't tell what survived of this run, it's read again next time
+            regmap_forget(map, reg, length);
+            reg = end;
+            continue;
+        }
+
+        uint8_t i = 0;
+        while (i < length) {
+            if (current[i] == map->value[reg + i]) {
+                i++;
+                continue;
+            }
+            uint8_t j = i;
+            while (j < length && current[j] != map->value[reg + j]) {
+                j++;
+            }
+            regmap_post(map, reg + i, &map->value[reg + i], j - i);
+            i = j;
+        }
+
+        reg = end;
+    }
+}
+
+void adv7511_map_invalidate(adv7511_regmap *map) {
+    for (uint16_t i = 0; i < map->size / 8; i++) {
+        map->known[i] = 0;
+    }
+}
+
+uint8_t adv7511_read_register(const uint8_t address) {
+    return adv7511_map_read(&main_map, address);
+}
+
 void adv7511_write_register(const uint8_t address, uint8_t value) {
-    I2C_HandleTypeDef* hi2c = adv7511_i2c_instance();
-    HAL_I2C_Mem_Write(hi2c, ADV7511_MAIN_I2C_ADDR, address, I2C_MEMADD_SIZE_8BIT, &value, 1, HAL_MAX_DELAY);
+    adv7511_map_write(&main_map, address, value);
 }
 
 void adv7511_update_register(const uint8_t address, const uint8_t mask, uint8_t new_value) {
-    const uint8_t current = adv7511_read_register(address);
-    uint8_t updated = (current & ~mask) | (new_value & mask);
-    adv7511_write_register(address, updated);
+    adv7511_map_update(&main_map, address, mask, new_value);
+}
+
+void adv7511_write_registers(const uint8_t address, const uint8_t *data, const uint8_t length) {
+    adv7511_map_write_burst(&main_map, address, data, length);
+}
+
+void adv7511_read_registers(const uint8_t address, uint8_t *data, const uint8_t length) {
+    adv7511_map_read_burst(&main_map, address, data, length);
+}
+
+void adv7511_read_status(adv7511_status *status) {
+    // 0x3E-0x42 in one go, 0x9E is too far away to be worth including
+    uint8_t regs[0x42 - 0x3E + 1];
+    adv7511_read_registers(0x3E, regs, sizeof(regs));
+
+    status->vic_detected = regs[0] >> 2;
+    status->hpd_status = regs[0x42 - 0x3E];
+    status->pll_lock = adv7511_get_pll_lock();
+}
+
+void adv7511_invalidate_registers() {
+    adv7511_map_invalidate(&main_map);
+}
+
+// Staged writes waiting for VSYNC, and 0x94 as it was before VSYNC got enabled for them
+static bool commit_pending = false;
+static uint32_t commit_tick = 0;
+static uint8_t commit_enable = 0;
+
+void adv7511_begin_update() {
+    adv7511_i2c_hold();
+}
+
+static void commit_finish() {
+    commit_pending = false;
+    adv7511_i2c_release();
+
+    // Leave VSYNC masked again so it doesn't raise the interrupt line every frame
+    adv7511_write_register(0x94, commit_enable);
+    adv7511_write_register(0x96, ADV7511_INT0_VSYNC);
+}
+
+void adv7511_commit_update() {
+    // Nothing on screen to tear while TMDS is down, no need to wait up to a frame
+    if (adv7511_get_tmds_power_down() != 0) {
+        if (commit_pending) {
+            commit_finish();
+        } else {
+            adv7511_i2c_release();
+        }
+        return;
+    }
+
+    // Writes staged since the last commit go out with the ones already waiting
+    if (commit_pending) {
+        return;
+    }
+
+    // Arm the VSYNC interrupt source and drop any stale edge, 0x96 is write 1 to clear.
+    // These are synchronous and bypass the staged writes.
+    commit_enable = adv7511_read_register(0x94);
+    adv7511_i2c_write(ADV7511_MAIN_I2C_ADDR, 0x94, &(uint8_t){commit_enable | ADV7511_INT0_VSYNC}, 1);
+    adv7511_i2c_write(ADV7511_MAIN_I2C_ADDR, 0x96, &(uint8_t){ADV7511_INT0_VSYNC}, 1);
+    commit_pending = true;
+    commit_tick = HAL_GetTick();
+}
+
+void adv7511_commit_poll() {
+    // No input video means no VSYNC, commit anyway after the timeout
+    if (commit_pending && (HAL_GetTick() - commit_tick) > ADV7511_VSYNC_TIMEOUT_MS) {
+        commit_finish();
+    }
+}
+
+bool adv7511_commit_pending() {
+    return commit_pending;
 }
 
 void adv7511_struct_init(adv7511 *encoder) {
+    encoder->status.vic_detected = 0;
+    encoder->status.hpd_status = 0;
+    encoder->status.pll_lock = 0;
     encoder->hot_plug_detect = 0;
     encoder->monitor_sense = 0;
     encoder->interrupt = 0;
     encoder->vic = 0;
+    encoder->power_state = ADV7511_POWER_OFF;
+    encoder->power_tick = 0;
+}
+
+static adv7511_ready_hook ready_hook = NULL;
+
+void adv7511_set_ready_hook(adv7511_ready_hook hook) {
+    ready_hook = hook;
 }
 
 void adv7511_power_up(adv7511 *encoder) {
+    // The shadow keeps the last configuration, it is replayed once the encoder is up.
     // Power up the encoder
-    adv7511_write_register(0x41, 0x10); // Power up
-    HAL_Delay(20);
-
-    // Reset
-    adv7511_write_register(0x41, 0x00);
-    HAL_Delay(20);
     adv7511_write_register(0x41, 0x10);
-    HAL_Delay(20);
+    encoder->power_state = ADV7511_POWER_WAKE;
+    encoder->power_tick = HAL_GetTick();
+}
+
+void adv7511_power_poll(adv7511 *encoder) {
+    if (encoder->power_state == ADV7511_POWER_OFF || encoder->power_state == ADV7511_POWER_READY) {
+        return;
+    }
+
+    if ((HAL_GetTick() - encoder->power_tick) < ADV7511_POWER_STEP_MS) {
+        return;
+    }
+
+    switch (encoder->power_state) {
+        case ADV7511_POWER_WAKE:
+            // Reset
+            adv7511_write_register(0x41, 0x00);
+            encoder->power_state = ADV7511_POWER_RESET;
+            break;
+
+        case ADV7511_POWER_RESET:
+            adv7511_write_register(0x41, 0x10);
+            encoder->power_state = ADV7511_POWER_SETTLE;
+            break;
+
+        default:
+            encoder->power_state = ADV7511_POWER_READY;
+            adv7511_map_replay(&main_map);
+            if (ready_hook) {
+                ready_hook(encoder);
+            }
+            break;
+    }
+    encoder->power_tick = HAL_GetTick();
+}
+
+bool adv7511_ready(const adv7511 *encoder) {
+    return encoder->power_state == ADV7511_POWER_READY;
+}
+
+void adv7511_power_down(adv7511 *encoder) {
+    // Past the shadow, it keeps the running configuration for the replay at the next power up
+    adv7511_i2c_update(ADV7511_MAIN_I2C_ADDR, 0xA1, adv7511_mask_tmds_power_down(), adv7511_mask_tmds_power_down());
+    adv7511_i2c_update(ADV7511_MAIN_I2C_ADDR, 0x41, adv7511_mask_power_down(), adv7511_mask_power_down());
+    encoder->power_state = ADV7511_POWER_OFF;
+}
+
+void adv7511_check_sink(adv7511 *encoder) {
+    encoder->hot_plug_detect = adv7511_get_hpd_state();
+    encoder->monitor_sense = adv7511_get_monitor_sense_state();
+    if (!encoder->hot_plug_detect && encoder->power_state != ADV7511_POWER_OFF) {
+        adv7511_power_down(encoder);
+    }
+}
+
+// Status bit of each source, index 0 is 0x96 / 0x94 and 1 is 0x97 / 0x95
+static const struct {
+    uint8_t index;
+    uint8_t bit;
+} irq_sources[ADV7511_IRQ_COUNT] = {
+    [ADV7511_IRQ_HPD]             = {0, ADV7511_INT0_HPD},
+    [ADV7511_IRQ_MONITOR_SENSE]   = {0, ADV7511_INT0_MONITOR_SENSE},
+    [ADV7511_IRQ_VSYNC]           = {0, ADV7511_INT0_VSYNC},
+    [ADV7511_IRQ_AUDIO_FIFO_FULL] = {0, ADV7511_INT0_AUDIO_FIFO_FULL},
+    [ADV7511_IRQ_EDID_READY]      = {0, ADV7511_INT0_EDID_READY},
+    [ADV7511_IRQ_DDC_ERROR]       = {1, ADV7511_INT1_DDC_ERROR},
+};
+
+static adv7511_irq_handler irq_handlers[ADV7511_IRQ_COUNT];
+static uint16_t irq_counts[ADV7511_IRQ_COUNT];
+
+void adv7511_irq_register(const adv7511_irq_source source, adv7511_irq_handler handler) {
+    if (source >= ADV7511_IRQ_COUNT) {
+        return;
+    }
+
+    irq_handlers[source] = handler;
+    if (source != ADV7511_IRQ_HPD && source != ADV7511_IRQ_MONITOR_SENSE) {
+        const uint8_t bit = irq_sources[source].bit;
+        adv7511_update_register(0x94 + irq_sources[source].index, bit, handler ? bit : 0);
+    }
+}
+
+uint16_t adv7511_irq_count(const adv7511_irq_source source) {
+    return source < ADV7511_IRQ_COUNT ? irq_counts[source] : 0;
 }
 
 void adv_handle_interrupts(adv7511 *encoder) {
-    if (encoder->interrupt) {
-        uint8_t interrupt_register = adv7511_read_register(0x96);
+    if (!encoder->interrupt) {
+        return;
+    }
+    encoder->interrupt = 0;
 
-        if (interrupt_register & ADV7511_INT0_HPD) {
-            encoder->hot_plug_detect = (adv7511_read_register(0x42) >> 6) & 0x01;
-        }
+    uint8_t pending[2];
+    adv7511_read_registers(0x96, pending, sizeof(pending));
 
-        if (interrupt_register & ADV7511_INT0_MONITOR_SENSE) {
-            encoder->monitor_sense = (adv7511_read_register(0x42) >> 5) & 0x01;
-        }
+    uint8_t handled[2] = {0, 0};
+    for (uint8_t i = 0; i < ADV7511_IRQ_COUNT; i++) {
+        handled[irq_sources[i].index] |= pending[irq_sources[i].index] & irq_sources[i].bit;
+    }
+
+    if (!(handled[0] | handled[1])) {
+        return;
+    }
+
+    // Clear before handling, anything raised while a handler runs asserts the pin again
+    adv7511_write_registers(0x96, handled, sizeof(handled));
+
+    // Start of vertical blanking, let the staged writes go
+    if ((handled[0] & ADV7511_INT0_VSYNC) && commit_pending) {
+        commit_finish();
+    }
+
+    if (handled[0] & ADV7511_INT0_HPD) {
+        encoder->hot_plug_detect = adv7511_get_hpd_state();
+    }
 
+    if (handled[0] & ADV7511_INT0_MONITOR_SENSE) {
+        encoder->monitor_sense = adv7511_get_monitor_sense_state();
+    }
+
+    // Without a sink only the HPD and monitor sense detection stays on
+    if (handled[0] & (ADV7511_INT0_HPD | ADV7511_INT0_MONITOR_SENSE)) {
         if (encoder->hot_plug_detect && encoder->monitor_sense) {
             adv7511_power_up(encoder);
+        } else if (!encoder->hot_plug_detect && encoder->power_state != ADV7511_POWER_OFF) {
+            adv7511_power_down(encoder);
+        }
+    }
+
+    for (uint8_t i = 0; i < ADV7511_IRQ_COUNT; i++) {
+        if (!(handled[irq_sources[i].index] & irq_sources[i].bit)) {
+            continue;
+        }
+
+        if (irq_counts[i] != UINT16_MAX) {
+            irq_counts[i]++;
         }
 
-        encoder->interrupt = 0;
-        // Re-enable interrupts
-        adv7511_update_register(0x96, 0b11000000, 0xC0);
+        if (irq_handlers[i]) {
+            irq_handlers[i](encoder, (adv7511_irq_source)i);
+        }
     }
 }
@@ -9,8 +9,19 @@
 
 #define BIT(nr) (1UL << (nr))
 
+// Interrupt status 0x96 / 0x97 (write 1 to clear), enabled by the same bits in 0x94 / 0x95
 #define ADV7511_INT0_HPD BIT(7)
 #define ADV7511_INT0_MONITOR_SENSE BIT(6)
+#define ADV7511_INT0_VSYNC BIT(5)
+#define ADV7511_INT0_AUDIO_FIFO_FULL BIT(4)
+#define ADV7511_INT0_EDID_READY BIT(2)
+#define ADV7511_INT1_DDC_ERROR BIT(7)
+
+// Longest wait for the start of vertical blanking, a bit over two 50Hz frames
+#define ADV7511_VSYNC_TIMEOUT_MS 50
+
+// Each power up step waits this long, the part has no status bit that says it is up
+#define ADV7511_POWER_STEP_MS 20
 
 #define ADV7511_VIC_CHANGED         0x80
 #define ADV7511_VIC_CHANGED_CLEAR   0x7F
@@ -18,20 +29,110 @@
 /* Hardware defined default addresses for I2C register maps */
 #define ADV7511_MAIN_I2C_ADDR           0x72 //0x72>>1
 
+#define ADV7511_MAIN_MAP_SIZE           256
+
+// Longest run of registers read back at once by adv7511_map_replay()
+#define ADV7511_REPLAY_CHUNK            16
+
+// Status registers polled by the main loop
+typedef struct
+{
+    uint8_t vic_detected;   // 0x3E [7:2]
+    uint8_t hpd_status;     // 0x42
+    uint8_t pll_lock;       // 0x9E [4]
+} adv7511_status;
+
+typedef enum
+{
+    ADV7511_POWER_OFF,      // Not started yet or powered down without a sink
+    ADV7511_POWER_WAKE,     // 0x41 = 0x10
+    ADV7511_POWER_RESET,    // 0x41 = 0x00
+    ADV7511_POWER_SETTLE,   // 0x41 = 0x10 again
+    ADV7511_POWER_READY
+} adv7511_power_state;
+
 typedef struct
 {
+    adv7511_status status;
     uint8_t hot_plug_detect;
     uint8_t monitor_sense;
     uint8_t interrupt;
     uint8_t vic;
+    uint8_t power_state;
+    uint32_t power_tick;    // Start of the current power up step
 } adv7511;
 
+// Called from adv7511_power_poll() once the encoder finished powering up
+typedef void (*adv7511_ready_hook)(adv7511 *encoder);
+
+typedef enum
+{
+    ADV7511_IRQ_HPD,
+    ADV7511_IRQ_MONITOR_SENSE,
+    ADV7511_IRQ_VSYNC,
+    ADV7511_IRQ_AUDIO_FIFO_FULL,
+    ADV7511_IRQ_EDID_READY,
+    ADV7511_IRQ_DDC_ERROR,
+    ADV7511_IRQ_COUNT
+} adv7511_irq_source;
+
+// Called from adv_handle_interrupts() in thread context, the status bit is already cleared
+typedef void (*adv7511_irq_handler)(adv7511 *encoder, const adv7511_irq_source source);
+
+// RAM shadow of an ADV7511 register map. Registers we wrote (or read once) are
+// known and masked updates are resolved locally, registers flagged in
+// volatile_regs (status / interrupt) always go to the bus.
+typedef struct
+{
+    uint8_t i2c_addr;
+    uint16_t size;                  // Registers >= size are not shadowed
+    const uint8_t *volatile_regs;   // Bitmap, size / 8 bytes
+    uint8_t *known;                 // Bitmap, size / 8 bytes
+    uint8_t *value;
+} adv7511_regmap;
+
+uint8_t adv7511_map_read(adv7511_regmap *map, const uint8_t address);
+void adv7511_map_write(adv7511_regmap *map, const uint8_t address, uint8_t value);
+void adv7511_map_update(adv7511_regmap *map, const uint8_t address, const uint8_t mask, uint8_t new_value);
+void adv7511_map_write_burst(adv7511_regmap *map, const uint8_t address, const uint8_t *data, const uint8_t length);
+void adv7511_map_read_burst(adv7511_regmap *map, const uint8_t address, uint8_t *data, const uint8_t length);
+void adv7511_map_replay(adv7511_regmap *map);
+void adv7511_map_invalidate(adv7511_regmap *map);
+
+// Starts the power up, adv7511_power_poll() has to be called from the main loop to finish it.
+// Registers that lost their value in a power cycle are written back from the shadow once it is up.
 void adv7511_power_up(adv7511 *encoder);
+void adv7511_power_poll(adv7511 *encoder);
+bool adv7511_ready(const adv7511 *encoder);
+// Powers down the encoder and TMDS drivers, HPD and monitor sense interrupts keep working
+void adv7511_power_down(adv7511 *encoder);
+// Reads HPD / monitor sense and powers down if no sink is attached
+void adv7511_check_sink(adv7511 *encoder);
+void adv7511_set_ready_hook(adv7511_ready_hook hook);
 void adv7511_update_register(const uint8_t address, const uint8_t mask, uint8_t new_value);
 uint8_t adv7511_read_register(const uint8_t address);
 void adv7511_write_register(const uint8_t address, uint8_t value);
+void adv7511_write_registers(const uint8_t address, const uint8_t *data, const uint8_t length);
+void adv7511_read_registers(const uint8_t address, uint8_t *data, const uint8_t length);
+void adv7511_read_status(adv7511_status *status);
+void adv7511_invalidate_registers();
 void adv7511_struct_init(adv7511 *encoder);
 
+// Register writes between begin and commit are staged and sent out together at the next VSYNC.
+// The commit only arms the VSYNC interrupt, adv_handle_interrupts() releases the writes when it
+// fires and adv7511_commit_poll() after ADV7511_VSYNC_TIMEOUT_MS without one. With TMDS down
+// they go out straight away.
+void adv7511_begin_update();
+void adv7511_commit_update();
+void adv7511_commit_poll();
+bool adv7511_commit_pending();
+
+// Registering a handler enables the source in 0x94 / 0x95, NULL disables it again.
+// HPD and monitor sense are always enabled, they drive the power up.
+void adv7511_irq_register(const adv7511_irq_source source, adv7511_irq_handler handler);
+uint16_t adv7511_irq_count(const adv7511_irq_source source);
+
+// Reads 0x96 / 0x97 in one go, clears the pending bits and dispatches them
 void adv_handle_interrupts(adv7511 *encoder);
 
 #endif // __ADV7511_MINIMAL_H__
@@ -0,0 +1,75 @@
+// ADV7511 main map fields, see the ADV7511 programming guide for details
+
+#ifndef __ADV7511_REGS_H__
+#define __ADV7511_REGS_H__
+
+#include "adv7511_minimal.h"
+
+// X(name, register, shift, width)
+#define ADV7511_MAIN_FIELDS(X) \
+    X(audio_n_high,             0x01, 0, 8) /* N [19:16] in [3:0] */ \
+    X(audio_n_mid,              0x02, 0, 8) /* N [15:8] */ \
+    X(audio_n_low,              0x03, 0, 8) /* N [7:0] */ \
+    X(audio_select,             0x0A, 4, 3) /* 000 I2S, 001 SPDIF */ \
+    X(spdif_enable,             0x0B, 7, 1) \
+    X(i2s_sample_freq,          0x15, 4, 4) /* 0010 48kHz */ \
+    X(video_input_id,           0x15, 0, 4) /* 0101 RGB/YCbCr 4:4:4 12bit DDR */ \
+    X(output_format,            0x16, 7, 1) /* 0 4:4:4, 1 4:2:2 */ \
+    X(color_depth,              0x16, 4, 2) /* 11 8bit */ \
+    X(input_style,              0x16, 2, 2) \
+    X(ddr_rising_edge,          0x16, 1, 1) \
+    X(output_color_space,       0x16, 0, 1) /* 0 RGB, 1 YCbCr */ \
+    X(de_generation,            0x17, 0, 1) \
+    X(csc_enable,               0x18, 7, 1) \
+    X(interlace_offset,         0x37, 5, 3) \
+    X(gc_packet_enable,         0x40, 7, 1) \
+    X(power_down,               0x41, 6, 1) \
+    X(sync_adjust_enable,       0x41, 1, 1) \
+    X(hpd_state,                0x42, 6, 1) \
+    X(monitor_sense_state,      0x42, 5, 1) \
+    X(bus_reverse,              0x48, 6, 1) \
+    X(ddr_alignment,            0x48, 5, 1) /* 0 D[17:0], 1 D[35:18] */ \
+    X(avi_update,               0x4A, 6, 1) /* Holds the AVI infoframe while set */ \
+    X(avi_y,                    0x55, 5, 2) /* 00 RGB, 01 4:2:2, 10 4:4:4 */ \
+    X(avi_picture_aspect,       0x56, 4, 2) /* 01 4:3, 10 16:9 */ \
+    X(avi_active_aspect,        0x56, 0, 4) /* 1000 same as picture */ \
+    X(vsync_int_enable,         0x94, 5, 1) \
+    X(pll_lock,                 0x9E, 4, 1) \
+    X(tmds_power_down,          0xA1, 2, 4) /* Clock driver and channels 0-2 */ \
+    X(clock_delay,              0xBA, 5, 3) /* 011 no delay, 400ps steps */ \
+    X(ddr_negative_edge_delay,  0xD0, 7, 1) \
+    X(ddr_edge_delay,           0xD0, 4, 3) /* 011 no delay, 400ps steps */ \
+    X(sync_pulse_select,        0xD0, 2, 2) /* 11 no sync pulse */ \
+    X(timing_gen_sequence,      0xD0, 1, 1) /* 1 data enable, then sync */ \
+    X(hpd_control,              0xD6, 6, 2) /* 11 HPD forced high */ \
+    X(tmds_clock_soft_on,       0xD6, 4, 1) \
+    X(video_gate,               0xD6, 0, 1)
+
+// Masks and shifts are constants, so a field spanning the whole register is a plain write and
+// anything narrower a single masked update. Neither reads the bus if the register is shadowed.
+static inline void adv7511_set_field(const uint8_t reg, const uint8_t shift, const uint8_t width, const uint8_t value) {
+    if (width == 8) {
+        adv7511_write_register(reg, value);
+    } else {
+        const uint8_t mask = ((1U << width) - 1) << shift;
+        adv7511_update_register(reg, mask, (uint8_t)(value << shift));
+    }
+}
+
+static inline uint8_t adv7511_get_field(const uint8_t reg, const uint8_t shift, const uint8_t width) {
+    return (adv7511_read_register(reg) >> shift) & ((1U << width) - 1);
+}
+
+// adv7511_set_<name>(value), adv7511_get_<name>(), and for writing several fields of a register in
+// one go adv7511_field_<name>(value) and adv7511_mask_<name>() to or together
+#define ADV7511_FIELD_ACCESSORS(name, reg, shift, width) \
+    static inline void adv7511_set_##name(const uint8_t value) { adv7511_set_field(reg, shift, width, value); } \
+    static inline uint8_t adv7511_get_##name() { return adv7511_get_field(reg, shift, width); } \
+    static inline uint8_t adv7511_field_##name(const uint8_t value) { return (uint8_t)((value & ((1U << width) - 1)) << shift); } \
+    static inline uint8_t adv7511_mask_##name() { return (uint8_t)(((1U << width) - 1) << shift); }
+
+ADV7511_MAIN_FIELDS(ADV7511_FIELD_ACCESSORS)
+
+#undef ADV7511_FIELD_ACCESSORS
+
+#endif // __ADV7511_REGS_H__
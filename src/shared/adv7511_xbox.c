@@ -1,4 +1,32 @@
 #include "adv7511_xbox.h"
+#include "adv7511_regs.h"
+
+static xbox_encoder init_xb_encoder;
+
+// Main map registers the cold init, the standalone modes and the BIOS programs write
+static const struct {
+    uint8_t start;
+    uint8_t length;
+} warm_ranges[] = {
+    { 0x01, 3 },    // Audio N
+    { 0x0A, 2 },    // Audio select, SPDIF
+    { 0x15, 0x1B }, // Input format, DE generation, CSC 0x18-0x2F
+    { 0x35, 8 },    // DE timing, pixel repeat, VIC
+    { 0x40, 2 },    // GC packet, power down and sync adjust
+    { 0x48, 1 },
+    { 0x4A, 1 },
+    { 0x55, 2 },    // AVI infoframe
+    { 0x94, 2 },    // Interrupt enables
+    { 0xA1, 1 },
+    { 0xAF, 1 },
+    { 0xBA, 1 },
+    { 0xD0, 1 },
+    { 0xD6, 7 },    // HPD control, fixed timing 0xD7-0xDC
+};
+
+static void init_adv_registers(adv7511 *encoder);
+
+static void init_adv_cold(adv7511 *encoder, const xbox_encoder xb_encoder);
 
 void init_adv(adv7511 *encoder, const xbox_encoder xb_encoder) {
     adv7511_i2c_init();
@@ -6,35 +34,76 @@ void init_adv(adv7511 *encoder, const xbox_encoder xb_encoder) {
     // Initialise the encoder object
     adv7511_struct_init(encoder);
 
+    init_adv_cold(encoder, xb_encoder);
+}
+
+bool init_adv_warm(adv7511 *encoder, const xbox_encoder xb_encoder) {
+    adv7511_i2c_init();
+    adv7511_struct_init(encoder);
+
+    // A power cycle or HPD power down since leaves 0x41 [6] set
+    uint8_t power = 0;
+    if (adv7511_i2c_read(ADV7511_MAIN_I2C_ADDR, 0x41, &power, 1) != HAL_OK || (power & adv7511_mask_power_down())) {
+        init_adv_cold(encoder, xb_encoder);
+        return false;
+    }
+
+    // Read what the cold init and the mode programs write into the shadow, masked updates and the
+    // replay after a hot plug then work from what the previous image programmed. Read only and
+    // self changing registers (revision, DDC state, chip ID) stay out, the replay would write them.
+    uint8_t regs[ADV7511_REPLAY_CHUNK];
+    for (uint8_t i = 0; i < sizeof(warm_ranges) / sizeof(warm_ranges[0]); i++) {
+        uint8_t reg = warm_ranges[i].start;
+        uint8_t remaining = warm_ranges[i].length;
+        while (remaining > 0) {
+            const uint8_t length = remaining < sizeof(regs) ? remaining : sizeof(regs);
+            adv7511_read_registers(reg, regs, length);
+            reg += length;
+            remaining -= length;
+        }
+    }
+
+    encoder->power_state = ADV7511_POWER_READY;
+    return true;
+}
+
+static void init_adv_cold(adv7511 *encoder, const xbox_encoder xb_encoder) {
     // [7:6] HPD Control (forced to high)
     // [5] Fixed 0
     // [4] TMDS Clock soft turn on
     // [3:1] Fixed 000
     // [0] AV gating off
-    adv7511_write_register(0xD6, 0b11010000);
+    adv7511_write_register(0xD6, adv7511_field_hpd_control(0b11) | adv7511_field_tmds_clock_soft_on(1));
 
-    // Power up the encoder and set fixed registers
+    // Power up the encoder, the fixed registers are set once it is up
+    init_xb_encoder = xb_encoder;
+    adv7511_set_ready_hook(init_adv_registers);
     adv7511_power_up(encoder);
-    HAL_Delay(50);
+}
+
+static void init_adv_registers(adv7511 *encoder) {
+    // Only once, later power ups after a hot plug keep the current settings
+    adv7511_set_ready_hook(NULL);
 
     // [3:0] Set video input mode to RGB/YCbCr 4:4:4, 12bit databus DDR
     // [7:4] Audio to 48kHz
-    adv7511_write_register(0x15, 0b00100101);
+    adv7511_write_register(0x15, adv7511_field_i2s_sample_freq(0b0010) | adv7511_field_video_input_id(0b0101));
 
     // [7] Output Format 4:4:4
     // [5:4] 8 bit video
     // [3:2] video style 1 (Y[3:0] Cb[7:0] first edge, Cr[7:0] Y[7:4] second edge)
     // [1] Set DDR Input Rising Edge
     // [0] YCbCr
-    adv7511_write_register(0x16, 0b00111011);
+    adv7511_write_register(0x16, adv7511_field_output_format(0) | adv7511_field_color_depth(0b11) | adv7511_field_input_style(0b10) |
+                                 adv7511_field_ddr_rising_edge(1) | adv7511_field_output_color_space(1));
 
     update_avi_infoframe(false);
 
     // Setup xbox encoder specific stuff (Xcalibur uses different settings)
-    init_adv_encoder_specific(xb_encoder);
+    init_adv_encoder_specific(init_xb_encoder);
 
     // [0] Enable DE generation. This is derived from HSYNC,VSYNC for video active framing
-    adv7511_update_register(0x17, 0b00000001, 0b00000001);
+    adv7511_set_de_generation(1);
 
     // Set Output to HDMI Mode (Instead of DVI Mode)
     // [7] HDCP Disabled
@@ -46,52 +115,59 @@ void init_adv(adv7511 *encoder, const xbox_encoder xb_encoder) {
     adv7511_write_register(0xAF, 0b00000110);
 
     // [7] Enable General Control Packet CHECK
-    adv7511_update_register(0x40, 0b10000000, 0b10000000);
+    adv7511_set_gc_packet_enable(1);
 
     init_adv_audio();
+
+    // Register writes are posted, make sure the encoder is set up before carrying on
+    adv7511_i2c_flush();
 }
 
 void init_adv_encoder_specific(const xbox_encoder xb_encoder) {
     if (xb_encoder == ENCODER_XCALIBUR) {
         // [6] Normal Bus Order, [5] DDR Alignment D[35:18] (left aligned)
-        adv7511_update_register(0x48, 0b01100000, 0b00100000);
+        adv7511_update_register(0x48, adv7511_mask_bus_reverse() | adv7511_mask_ddr_alignment(),
+                                adv7511_field_bus_reverse(0) | adv7511_field_ddr_alignment(1));
         // [7] Disable DDR Negative Edge CLK Delay, [6:4] with -400ps delay
         // [3:2] No sync pulse, [1] Data enable, then sync, [0] Fixed
-        adv7511_write_register(0xD0, 0b00101110);
+        adv7511_write_register(0xD0, adv7511_field_ddr_negative_edge_delay(0) | adv7511_field_ddr_edge_delay(0b010) |
+                                     adv7511_field_sync_pulse_select(0b11) | adv7511_field_timing_gen_sequence(1));
         // [7:5] -0.8ns clock delay
-        adv7511_update_register(0xBA, 0b11100000, 0b00100000);
+        adv7511_set_clock_delay(0b001);
     } else {
         // [6] LSB .... MSB Reverse Bus Order, [5] DDR Alignment D[17:0] (right aligned)
-        adv7511_update_register(0x48, 0b01100000, 0b01000000);
+        adv7511_update_register(0x48, adv7511_mask_bus_reverse() | adv7511_mask_ddr_alignment(),
+                                adv7511_field_bus_reverse(1) | adv7511_field_ddr_alignment(0));
         // [7] Enable DDR Negative Edge CLK Delay, [6:4] with 0ps delay
         // [3:2] No sync pulse, [1] Data enable, then sync, [0] Fixed
-        adv7511_write_register(0xD0, 0b10111110);
+        adv7511_write_register(0xD0, adv7511_field_ddr_negative_edge_delay(1) | adv7511_field_ddr_edge_delay(0b011) |
+                                     adv7511_field_sync_pulse_select(0b11) | adv7511_field_timing_gen_sequence(1));
         // [7:5] No clock delay
-        adv7511_update_register(0xBA, 0b11100000, 0b01100000);
+        adv7511_set_clock_delay(0b011);
     }
 }
 
 void init_adv_audio() {
     // [19:0] Set 48kHz Audio clock CHECK (N Value)
-    adv7511_write_register(0x01, 0x00);
-    adv7511_write_register(0x02, 0x18);
-    adv7511_write_register(0x03, 0x00);
+    adv7511_set_audio_n_high(0x00);
+    adv7511_set_audio_n_mid(0x18);
+    adv7511_set_audio_n_low(0x00);
 
     // [6:4] Set SPDIF audio source
-    adv7511_update_register(0x0A, 0b01110000, 0b00010000);
+    adv7511_set_audio_select(0b001);
 
     // [7] SPDIF enable
-    adv7511_update_register(0x0B, 0b10000000, 0b10000000);
+    adv7511_set_spdif_enable(1);
 }
 
 void update_avi_infoframe(const bool widescreen) {
     // [6] Start AVI Infoframe Update
-    adv7511_update_register(0x4A, 0b01000000, 0b01000000);
+    adv7511_set_avi_update(1);
     // [6:5] Infoframe output format to YCbCr4:4:4
-    adv7511_update_register(0x55, 0b01100000, 0b01000000);
+    adv7511_set_avi_y(0b10);
     // [5:4] Set aspect ratio
     // [3:0] Active format aspect ratio, same as aspect ratio
-    adv7511_write_register(0x56, widescreen ? 0b00101000 : 0b00011000);
+    adv7511_write_register(0x56, adv7511_field_avi_picture_aspect(widescreen ? 0b10 : 0b01) | adv7511_field_avi_active_aspect(0b1000));
     // [6] End AVI Infoframe Update
-    adv7511_update_register(0x4A, 0b01000000, 0b00000000);
+    adv7511_set_avi_update(0);
 }
@@ -8,6 +8,9 @@
 #include "xbox_video_standalone.h"
 
 void init_adv(adv7511 *encoder, const xbox_encoder xb_encoder);
+// Takes over an encoder the previous image left set up for xb_encoder without resetting it.
+// Falls back to init_adv() and returns false if the encoder was powered down meanwhile.
+bool init_adv_warm(adv7511 *encoder, const xbox_encoder xb_encoder);
 
 void init_adv_encoder_specific(const xbox_encoder xb_encoder);
 
@@ -13,6 +13,8 @@
 
 #define BOOTLOADER_MAGIC_VALUE      0xDEADBEEF
 #define BOOTLOADER_FLAG_ADDRESS     ((volatile uint32_t*)(RAM_START_ADDRESS + 0xf0))
+// ADV7511 state left for the next image, up to the end of the reserved area
+#define HANDOFF_ADDRESS             (RAM_START_ADDRESS + 0x100)
 
 // Bootloader and application addresses (20KB bootloader)
 #define BOOTLOADER_SIZE           0x5000  // 20KB
@@ -21,6 +23,8 @@
 #define APP_TOTAL_SIZE            (FLASH_START_ADDRESS + FLASH_TOTAL_SIZE - BOOTLOADER_SIZE)
 #define APP_INVALID_FLAG          0x5A5A
 #define APP_INVALID_FLAG_ADDRESS  (APP_START_ADDRESS + APP_SIZE_BYTES - 2)
+// Last applied BIOS video settings, the page below the flag page (application.ld stops before it)
+#define LAST_MODE_PAGE            0x3E
 
 // ============================================================================
 // I2C
@@ -43,6 +47,13 @@
 #define I2C_HDMI_COMMAND_READ_RAM_PAGE_CRC3 9 // Read crc byte 3 (from ram buffer)
 #define I2C_HDMI_COMMAND_READ_RAM_PAGE_CRC4 10 // Read crc byte 4 (from ram buffer)
 
+#define I2C_HDMI_COMMAND_READ_ADV_I2C_RECOVERIES 11 // Read how often the ADV7511 bus was recovered since boot (saturates at 255)
+#define I2C_HDMI_COMMAND_READ_SMBUS_RECOVERIES 12 // Read how often the SMBus slave was reset since boot (saturates at 255)
+#define I2C_HDMI_COMMAND_READ_IDLE_PERCENT 13 // Read the share of the last second the CPU spent asleep
+#define I2C_HDMI_COMMAND_READ_LINK_UNLOCKS 14 // Read how often the HDMI PLL lost lock since boot (saturates at 255)
+#define I2C_HDMI_COMMAND_READ_RAM_BLOCK 15 // SMBus block read of up to SMBUS_BLOCK_MAX bytes from ram buffer at bank + index (post increments)
+#define I2C_HDMI_COMMAND_READ_FLASH_STATUS 16 // SMBus block read of the flash work status then the CRC of the last page read or written
+
 // Write Actions
 #define I2C_HDMI_COMMAND_WRITE_CONFIG 128 // Write value to config buffer at current bank + index (post increments)
 #define I2C_HDMI_COMMAND_WRITE_CONFIG_BANK 129 // Write config buffer bank (sets index to 0)
@@ -57,12 +68,18 @@
 #define I2C_HDMI_COMMAND_WRITE_RAM_APPLY 137 // Applies ram buffer to page with value alseo erases + updates crc (validates page for current mode)
 
 #define I2C_HDMI_COMMAND_WRITE_APP_FLASH_MODE 138 // 0 to mark flash ended, 1 to mark flashing began
+#define I2C_HDMI_COMMAND_WRITE_RAM_BLOCK 139 // SMBus block write of up to SMBUS_BLOCK_MAX bytes to ram buffer at bank + index (post increments)
+#define I2C_HDMI_COMMAND_WRITE_CONFIG_BLOCK 140 // SMBus block write of the packed settings plus the apply value, same as config writes followed by apply
 
 #define I2C_HDMI_VERSION1 0
 #define I2C_HDMI_VERSION2 1
 #define I2C_HDMI_VERSION3 2
 #define I2C_HDMI_VERSION4 0
 
+#define I2C_HDMI_FLASH_IDLE 0 // Flash work done
+#define I2C_HDMI_FLASH_BUSY 1 // Flash work queued or running, the ram buffer is read only
+#define I2C_HDMI_FLASH_ERROR 2 // A page failed to program or a request was refused since the last idle
+
 #define I2C_HDMI_MODE_BOOTLOADER 1
 #define I2C_HDMI_MODE_APPLICATION 2
 
@@ -78,4 +95,11 @@
 #define SMBUS_SMS_RESPONSE_READY ((uint32_t)0x00000010)  /*!< Slave has reply ready for transmission */
 #define SMBUS_SMS_IGNORED        ((uint32_t)0x00000020)  /*!< The current command is not intended for this slave, ignore it */
 
+#define SMBUS_TIMEOUT_MS 35 // SMBus tTIMEOUT upper bound, a transaction stuck longer resets the slave
+// Stored settings applied at boot are dropped if the BIOS doesn't confirm them by then. Without a BIOS
+// (e.g. a standalone console) the speculative mode stays up this long before standalone detection takes over.
+#define SMBUS_SPECULATIVE_TIMEOUT_MS 20000
+
+#define SMBUS_BLOCK_MAX 32 // SMBus 2.0 limit on the byte count of a block transfer
+
 #define RAM_BUFFER_SIZE 1024
@@ -26,8 +26,11 @@ bool flash_erase_page(uint16_t page)
 
 bool flash_write_page(uint16_t page, uint8_t* data, uint16_t data_size)
 {
-    uint32_t flash_addr = FLASH_START_ADDRESS + (page * FLASH_PAGE_SIZE);
+    return flash_program(FLASH_START_ADDRESS + (page * FLASH_PAGE_SIZE), data, data_size);
+}
 
+bool flash_program(uint32_t flash_addr, const uint8_t* data, uint16_t data_size)
+{
     HAL_FLASH_Unlock();
 
     HAL_StatusTypeDef status = HAL_OK;
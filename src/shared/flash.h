@@ -5,6 +5,8 @@
 
 bool flash_erase_page(uint16_t page);
 bool flash_write_page(uint16_t page, uint8_t* data, uint16_t data_size);
+// Programs erased flash at any half word aligned address, data_size has to be even
+bool flash_program(uint32_t flash_addr, const uint8_t* data, uint16_t data_size);
 uint32_t flash_copy_page(uint16_t page, uint8_t* data, uint16_t data_size);
 void flash_remove_flag();
 void flash_set_flag();
\ No newline at end of file
@@ -19,11 +19,11 @@ void init_gpio() {
     gpio.Pull = GPIO_PULLUP;
     HAL_GPIO_Init(GPIOC, &gpio);
 
-    // ?
-    gpio.Pin = GPIO_PIN_7;
-    gpio.Mode = GPIO_MODE_IT_RISING_FALLING;
+    // ADV7511 interrupt, only the assert edge is of interest
+    gpio.Pin = ADV_IRQ_PIN;
+    gpio.Mode = GPIO_MODE_IT_FALLING;
     gpio.Pull = GPIO_NOPULL;
-    HAL_GPIO_Init(GPIOF, &gpio);
+    HAL_GPIO_Init(ADV_IRQ_PORT, &gpio);
 }
 
 void set_led_1(bool state) {
@@ -37,3 +37,7 @@ void set_led_2(bool state) {
 bool recovery_jumper_enabled() {
     return !HAL_GPIO_ReadPin(GPIOC, GPIO_PIN_15);
 }
+
+bool adv_irq_asserted() {
+    return !HAL_GPIO_ReadPin(ADV_IRQ_PORT, ADV_IRQ_PIN);
+}
@@ -3,10 +3,17 @@
 
 #include "stdbool.h"
 
+// ADV7511 interrupt output on PF7, open drain and active low
+#define ADV_IRQ_PORT    GPIOF
+#define ADV_IRQ_PIN     GPIO_PIN_7
+#define ADV_IRQ_IRQn    EXTI4_15_IRQn
+#define ADV_IRQ_HANDLER EXTI4_15_IRQHandler
+
 void init_gpio();
 
 void set_led_1(bool state); // Green led for the HD+
 void set_led_2(bool state); // Blue led for the HD+
 bool recovery_jumper_enabled();
+bool adv_irq_asserted();
 
 #endif // __GPIO_H__
@@ -0,0 +1,31 @@
+#include <stddef.h>
+#include "handoff.h"
+#include "crc32.h"
+#include "defines.h"
+
+#define HANDOFF_BLOCK ((volatile adv_handoff *)HANDOFF_ADDRESS)
+
+_Static_assert(HANDOFF_ADDRESS + sizeof(adv_handoff) <= RAM_START_ADDRESS + RAM_RESERVED_AT_START, "Hand-off block outside the reserved RAM");
+
+static uint32_t handoff_checksum(const adv_handoff *handoff) {
+    return crc32_calc((uint32_t)handoff, offsetof(adv_handoff, checksum));
+}
+
+void handoff_store(const uint8_t encoder, const uint8_t vic, const uint8_t flags) {
+    adv_handoff handoff = {
+        .magic = HANDOFF_MAGIC,
+        .encoder = encoder,
+        .vic = vic,
+        .flags = flags,
+        .reserved = 0,
+    };
+    handoff.checksum = handoff_checksum(&handoff);
+    *HANDOFF_BLOCK = handoff;
+}
+
+bool handoff_take(adv_handoff *handoff) {
+    *handoff = *HANDOFF_BLOCK;
+    HANDOFF_BLOCK->magic = 0;
+
+    return handoff->magic == HANDOFF_MAGIC && handoff->checksum == handoff_checksum(handoff);
+}
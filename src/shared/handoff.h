@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// What one image (bootloader or application) left the ADV7511 set up as, kept in the reserved
+// RAM at HANDOFF_ADDRESS across the reset between them. It is taken at most once.
+
+#define HANDOFF_MAGIC       0x41445648  // "HVDA"
+#define HANDOFF_INIT_DONE   0x01        // init_adv() finished and the encoder is powered up
+
+typedef struct
+{
+    uint32_t magic;
+    uint8_t encoder;    // xbox_encoder the encoder specific registers are set up for
+    uint8_t vic;        // Last VIC programmed in standalone mode
+    uint8_t flags;
+    uint8_t reserved;
+    uint32_t checksum;  // crc32 of everything above
+} adv_handoff;
+
+void handoff_store(const uint8_t encoder, const uint8_t vic, const uint8_t flags);
+// Copies a valid block to handoff and invalidates it, false if there is none
+bool handoff_take(adv_handoff *handoff);
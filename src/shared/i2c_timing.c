@@ -0,0 +1,95 @@
+#include "i2c_timing.h"
+
+// Analog filter delay range
+#define I2C_AF_MIN_NS 50
+
+typedef struct {
+    uint32_t speed_hz;
+    uint16_t low_min_ns;
+    uint16_t high_min_ns;
+    uint16_t rise_max_ns;
+    uint16_t fall_max_ns;
+    uint16_t setup_min_ns;
+} i2c_timing_spec;
+
+// I2C specification limits for standard, fast and fast mode plus
+static const i2c_timing_spec specs[] = {
+    {I2C_SPEED_STANDARD,  4700, 4000, 1000, 300, 250},
+    {I2C_SPEED_FAST,      1300,  600,  300, 300, 100},
+    {I2C_SPEED_FAST_PLUS,  500,  260,  120, 120,  50},
+};
+
+static inline uint32_t div_ceil(const uint32_t a, const uint32_t b) {
+    return (a + b - 1) / b;
+}
+
+uint32_t i2c_timing(const uint32_t kernel_clock_hz, const uint32_t speed_hz) {
+    if (kernel_clock_hz == 0 || speed_hz == 0) {
+        return 0;
+    }
+
+    const i2c_timing_spec *spec = NULL;
+    for (uint8_t i = 0; i < sizeof(specs) / sizeof(specs[0]); i++) {
+        if (speed_hz <= specs[i].speed_hz) {
+            spec = &specs[i];
+            break;
+        }
+    }
+    if (spec == NULL) {
+        return 0;
+    }
+
+    // Picoseconds keep the division exact enough at 48MHz
+    const uint32_t clock_ps = 1000000000UL / (kernel_clock_hz / 1000);
+    const uint32_t period_ps = 1000000000UL / (speed_hz / 1000);
+
+    // Both SCL edges go through the analog filter and two kernel clocks of sync
+    const uint32_t sync_ps = 2 * (I2C_AF_MIN_NS * 1000 + 2 * clock_ps);
+
+    // The lowest prescaler that fits gives the finest resolution
+    for (uint32_t presc = 0; presc < 16; presc++) {
+        const uint32_t tick_ps = (presc + 1) * clock_ps;
+
+        // Data setup time, tSCLDEL = (SCLDEL + 1) * tPRESC
+        uint32_t scldel = div_ceil((spec->rise_max_ns + spec->setup_min_ns) * 1000, tick_ps);
+        scldel = scldel ? scldel - 1 : 0;
+
+        // Data hold time, tSDADEL >= tf - tAF - 3 * tI2CCLK
+        const uint32_t hold_ps = spec->fall_max_ns * 1000;
+        const uint32_t hold_min_ps = I2C_AF_MIN_NS * 1000 + 3 * clock_ps;
+        const uint32_t sdadel = (hold_ps > hold_min_ps) ? div_ceil(hold_ps - hold_min_ps, tick_ps) : 0;
+
+        if (scldel > 15 || sdadel > 15) {
+            continue;
+        }
+
+        // SCL low and high in prescaled ticks, spread what is left over the spec minimums
+        uint32_t low = div_ceil(spec->low_min_ns * 1000, tick_ps);
+        uint32_t high = div_ceil(spec->high_min_ns * 1000, tick_ps);
+        // A slow kernel clock may not make the period, the minimums alone are the best it gets
+        const uint32_t total = (period_ps > sync_ps) ? div_ceil(period_ps - sync_ps, tick_ps) : 0;
+        if (total > low + high) {
+            const uint32_t extra = total - low - high;
+            const uint32_t extra_low = extra * spec->low_min_ns / (spec->low_min_ns + spec->high_min_ns);
+            low += extra_low;
+            high += extra - extra_low;
+        }
+
+        if (low > 256 || high > 256) {
+            continue;
+        }
+
+        return (presc << I2C_TIMINGR_PRESC_Pos) | (scldel << I2C_TIMINGR_SCLDEL_Pos) | (sdadel << I2C_TIMINGR_SDADEL_Pos) |
+               ((high - 1) << I2C_TIMINGR_SCLH_Pos) | ((low - 1) << I2C_TIMINGR_SCLL_Pos);
+    }
+
+    return 0;
+}
+
+uint32_t i2c_kernel_clock(const I2C_TypeDef *instance) {
+    // I2C1 can run from HSI or SYSCLK, I2C2 always runs from PCLK
+    if (instance == I2C1) {
+        return (__HAL_RCC_GET_I2C1_SOURCE() == RCC_I2C1CLKSOURCE_HSI) ? HSI_VALUE : HAL_RCC_GetSysClockFreq();
+    }
+    return HAL_RCC_GetPCLK1Freq();
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "stm32.h"
+
+#define I2C_SPEED_STANDARD   100000
+#define I2C_SPEED_FAST       400000
+#define I2C_SPEED_FAST_PLUS 1000000
+
+// TIMINGR value for the requested bus speed, never faster than asked for. 0 if it can't be met.
+// Assumes the analog filter on and the digital filter off, as both buses are set up.
+uint32_t i2c_timing(const uint32_t kernel_clock_hz, const uint32_t speed_hz);
+
+// Clock feeding the timing generator of the given instance
+uint32_t i2c_kernel_clock(const I2C_TypeDef *instance);
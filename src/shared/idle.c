@@ -0,0 +1,93 @@
+#include <stdbool.h>
+#include "idle.h"
+#include "stm32f0xx_hal.h"
+
+static uint32_t window_start = 0;
+static uint32_t window_idle = 0;   // SysTick counts spent asleep in the current window
+static uint8_t last_percent = 0;
+
+static void idle_account(const uint32_t counts, const uint32_t per_ms) {
+    window_idle += counts;
+
+    const uint32_t elapsed = HAL_GetTick() - window_start;
+    if (elapsed >= IDLE_WINDOW_MS) {
+        const uint32_t total = elapsed * per_ms;
+        last_percent = (uint8_t)(window_idle >= total ? 100 : window_idle / (total / 100));
+        window_start = HAL_GetTick();
+        window_idle = 0;
+    }
+}
+
+static inline bool systick_expired() {
+    return (SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) || (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk);
+}
+
+void idle_sleep(uint32_t max_ms) {
+    const uint32_t per_ms = (SysTick->LOAD & SysTick_LOAD_RELOAD_Msk) + 1;
+    const uint32_t limit = SysTick_LOAD_RELOAD_Msk / per_ms;
+    if (max_ms > limit) {
+        max_ms = limit;
+    }
+
+    // Up to the next regular tick, nothing to reprogram
+    if (max_ms <= 1) {
+        // Reading CTRL clears a COUNTFLAG left over from an earlier wrap
+        (void)SysTick->CTRL;
+        const uint32_t before = SysTick->VAL;
+        __WFI();
+        const uint32_t after = SysTick->VAL;
+        idle_account(systick_expired() ? before + (per_ms - after) : before - after, per_ms);
+        return;
+    }
+
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+    if (systick_expired()) {
+        // The tick is due anyway, let it run
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+        return;
+    }
+
+    // Expire on the tick boundary max_ms from now
+    const uint32_t to_tick = SysTick->VAL;
+    const uint32_t reload = to_tick + (max_ms - 1) * per_ms - 1;
+    SysTick->LOAD = reload;
+    SysTick->VAL = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+
+    __WFI();
+
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+    uint32_t slept;
+    uint32_t ticks;
+    uint32_t remaining;
+    if (systick_expired()) {
+        // The pending SysTick interrupt counts the last tick itself
+        slept = reload + 1;
+        ticks = max_ms - 1;
+        remaining = per_ms;
+    } else {
+        slept = reload + 1 - SysTick->VAL;
+        if (slept < to_tick) {
+            ticks = 0;
+            remaining = to_tick - slept;
+        } else {
+            ticks = 1 + (slept - to_tick) / per_ms;
+            remaining = per_ms - (slept - to_tick) % per_ms;
+        }
+    }
+
+    uwTick += ticks;
+
+    // A reload of 0 would stop the counter
+    if (remaining < 2) {
+        remaining = 2;
+    }
+
+    // Finish the tick in progress, then back to the regular period
+    SysTick->LOAD = remaining - 1;
+    SysTick->VAL = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    SysTick->LOAD = per_ms - 1;
+
+    idle_account(slept, per_ms);
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdint.h>
+
+// Tickless Sleep mode. SysTick is reprogrammed to fire once at the end of the sleep and
+// uwTick is advanced by the time slept, so HAL_GetTick() stays correct. Any interrupt
+// (ADV7511 pin, I2C2 address match, ...) ends the sleep early.
+// Stop mode is not used, I2C2 can't wake the F030 from Stop and SysTick doesn't run in it.
+
+// Percentage is taken over windows of this length
+#define IDLE_WINDOW_MS 1000
+
+// Has to be called with interrupts masked (__disable_irq), returns with them still masked.
+// The interrupt that woke the core runs once the caller unmasks them again.
+void idle_sleep(uint32_t max_ms);
+
+// Share of the last full window spent asleep
+uint8_t idle_percent();
@@ -0,0 +1,256 @@
+#include "smbus_ram.h"
+#include "crc32.h"
+#include "defines.h"
+#include "flash.h"
+#include "stm32.h"
+#include <string.h>
+
+typedef struct {
+    uint8_t op;
+    uint8_t page;
+} smbus_ram_job;
+
+static uint16_t ram_buffer_bank = 0;
+static uint16_t ram_buffer_index = 0;
+static uint8_t ram_buffer[RAM_BUFFER_SIZE];
+static volatile uint32_t ram_buffer_crc = 0;
+
+// Single producer ring, the I2C2 interrupt adds at the tail and the main loop removes from the
+// head once a job is done, so a queued or running job both read as busy
+static smbus_ram_job queue[SMBUS_RAM_QUEUE_SIZE];
+static volatile uint8_t queue_head = 0;
+static volatile uint8_t queue_tail = 0;
+static volatile bool job_failed = false;  // Since the queue last went idle
+static volatile bool reset_pending = false;
+// Set once the host read I2C_HDMI_COMMAND_READ_FLASH_STATUS. Until then it's an older updater that
+// reads the CRC straight after the command, so the work is done in the interrupt as it used to be.
+static bool status_polled = false;
+
+static bool smbus_ram_run(const smbus_ram_job *job);
+
+static uint16_t ram_buffer_offset(void)
+{
+    return (ram_buffer_bank << 8) | ram_buffer_index;
+}
+
+// Moves the ram buffer bank + index on by count bytes
+static void ram_buffer_advance(const uint16_t count)
+{
+    uint16_t ram_offset = ram_buffer_offset() + count;
+    ram_buffer_bank = ram_offset >> 8;
+    ram_buffer_index = ram_offset & 0xff;
+}
+
+uint8_t smbus_ram_read(const uint8_t command, uint8_t *data, const uint8_t length)
+{
+    uint16_t ram_offset = ram_buffer_offset();
+    if (ram_offset >= RAM_BUFFER_SIZE)
+    {
+        data[0] = 0xFF;
+        return 1;
+    }
+    data[0] = ram_buffer[ram_offset];
+    ram_buffer_advance(1);
+    return 1;
+}
+
+// SMBus block read, up to length bytes (post increments)
+uint8_t smbus_ram_read_block(const uint8_t command, uint8_t *data, const uint8_t length)
+{
+    uint16_t ram_offset = ram_buffer_offset();
+    uint16_t count = ram_offset < RAM_BUFFER_SIZE ? RAM_BUFFER_SIZE - ram_offset : 0;
+    if (count > length)
+    {
+        count = length;
+    }
+    if (count > 0)
+    {
+        memcpy(data, &ram_buffer[ram_offset], count);
+    }
+    ram_buffer_advance(count);
+    return (uint8_t)count;
+}
+
+uint8_t smbus_ram_read_crc(const uint8_t command, uint8_t *data, const uint8_t length)
+{
+    // The CRC of a queued page isn't known yet, don't hand out the previous one
+    if (smbus_ram_busy())
+    {
+        data[0] = SMBUS_RAM_CRC_NOT_READY;
+        return 1;
+    }
+    const uint8_t shift = (I2C_HDMI_COMMAND_READ_RAM_PAGE_CRC4 - command) * 8;
+    data[0] = (uint8_t)((ram_buffer_crc >> shift) & 0xff);
+    return 1;
+}
+
+uint8_t smbus_ram_read_status(const uint8_t command, uint8_t *data, const uint8_t length)
+{
+    status_polled = true;
+    const uint32_t crc = ram_buffer_crc;
+    if (smbus_ram_busy())
+    {
+        data[0] = I2C_HDMI_FLASH_BUSY;
+    }
+    else
+    {
+        data[0] = job_failed ? I2C_HDMI_FLASH_ERROR : I2C_HDMI_FLASH_IDLE;
+    }
+    data[1] = (uint8_t)(crc >> 24);
+    data[2] = (uint8_t)(crc >> 16);
+    data[3] = (uint8_t)(crc >> 8);
+    data[4] = (uint8_t)crc;
+    return 5;
+}
+
+uint8_t smbus_ram_read_page(const uint8_t command, uint8_t *data, const uint8_t length)
+{
+    smbus_ram_queue(SMBUS_RAM_READ_PAGE, data[0]);
+    return 0;
+}
+
+// The ram buffer belongs to the queued jobs until they're done
+static bool ram_buffer_writable(void)
+{
+    if (smbus_ram_busy())
+    {
+        job_failed = true;
+        return false;
+    }
+    return true;
+}
+
+bool smbus_ram_writable(void)
+{
+    return !smbus_ram_busy();
+}
+
+uint8_t smbus_ram_write(const uint8_t command, uint8_t *data, const uint8_t length)
+{
+    uint16_t ram_offset = ram_buffer_offset();
+    if (ram_offset < RAM_BUFFER_SIZE && ram_buffer_writable())
+    {
+        ram_buffer[ram_offset] = data[0];
+        ram_buffer_advance(1);
+    }
+    return 0;
+}
+
+uint8_t smbus_ram_write_block(const uint8_t command, uint8_t *data, const uint8_t length)
+{
+    uint16_t ram_offset = ram_buffer_offset();
+    if (ram_offset >= RAM_BUFFER_SIZE || !ram_buffer_writable())
+    {
+        return 0;
+    }
+    uint16_t count = length;
+    if (count > RAM_BUFFER_SIZE - ram_offset)
+    {
+        count = RAM_BUFFER_SIZE - ram_offset;
+    }
+    memcpy(&ram_buffer[ram_offset], data, count);
+    ram_buffer_advance(count);
+    return 0;
+}
+
+uint8_t smbus_ram_write_bank(const uint8_t command, uint8_t *data, const uint8_t length)
+{
+    ram_buffer_bank = data[0];
+    ram_buffer_index = 0;
+    return 0;
+}
+
+uint8_t smbus_ram_write_index(const uint8_t command, uint8_t *data, const uint8_t length)
+{
+    ram_buffer_index = data[0];
+    return 0;
+}
+
+// -------------------- Flash Work --------------------
+bool smbus_ram_queue(const smbus_ram_op op, const uint8_t page)
+{
+    if (!status_polled)
+    {
+        const smbus_ram_job job = { op, page };
+        job_failed = !smbus_ram_run(&job);
+        return !job_failed;
+    }
+
+    const uint8_t next = (queue_tail + 1) % SMBUS_RAM_QUEUE_SIZE;
+    if (next == queue_head)
+    {
+        job_failed = true;
+        return false;
+    }
+
+    if (queue_head == queue_tail)
+    {
+        job_failed = false;
+    }
+    queue[queue_tail].op = op;
+    queue[queue_tail].page = page;
+    queue_tail = next;
+    return true;
+}
+
+void smbus_ram_request_reset(void)
+{
+    reset_pending = true;
+}
+
+bool smbus_ram_busy(void)
+{
+    return queue_head != queue_tail;
+}
+
+static bool smbus_ram_run(const smbus_ram_job *job)
+{
+    switch (job->op)
+    {
+        case SMBUS_RAM_READ_PAGE:
+        {
+            ram_buffer_crc = flash_copy_page(job->page, ram_buffer, RAM_BUFFER_SIZE);
+            return true;
+        }
+        case SMBUS_RAM_APPLY:
+        {
+            bool ok = flash_erase_page(job->page) && flash_write_page(job->page, ram_buffer, RAM_BUFFER_SIZE);
+            // Read back, a page that doesn't match the buffer didn't program
+            const uint32_t crc = crc32_calc(FLASH_START_ADDRESS + (job->page * FLASH_PAGE_SIZE), RAM_BUFFER_SIZE);
+            ok = ok && crc == crc32_calc((uint32_t)ram_buffer, RAM_BUFFER_SIZE);
+            ram_buffer_crc = crc;
+            return ok;
+        }
+        case SMBUS_RAM_SET_FLAG:
+        {
+            flash_set_flag();
+            return true;
+        }
+        case SMBUS_RAM_CLEAR_FLAG:
+        {
+            flash_remove_flag();
+            return true;
+        }
+    }
+    return false;
+}
+
+// Runs everything queued. Interrupts stay enabled but code runs from flash, so an erase or
+// program still stalls every interrupt handler until it's done (see smbus_ram.h).
+void smbus_ram_poll(void)
+{
+    while (queue_head != queue_tail)
+    {
+        if (!smbus_ram_run(&queue[queue_head]))
+        {
+            job_failed = true;
+        }
+        queue_head = (queue_head + 1) % SMBUS_RAM_QUEUE_SIZE;
+    }
+
+    // Jobs queued ahead of a mode change still land, the transaction that asked is finished
+    if (reset_pending && !smbus_slave_busy())
+    {
+        NVIC_SystemReset();
+    }
+}
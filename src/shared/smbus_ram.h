@@ -0,0 +1,46 @@
+#pragma once
+
+#include "smbus_slave.h"
+
+// The ram buffer both images stage flash pages in, moved over SMBus at bank + index.
+// Once the host has read I2C_HDMI_COMMAND_READ_FLASH_STATUS, flash work is queued from the I2C2
+// interrupt and done by smbus_ram_poll() in the main loop, and the host polls the status until it
+// reads idle. Until then ram buffer writes are NACKed. Older updaters never read the status and
+// expect the CRC right after the command, for them the work still runs in the interrupt.
+//
+// Queuing keeps the copy and CRC of READ_PAGE interruptible and lets the transaction that asked
+// finish first. It doesn't make erasing and programming free: the flash can't be read while it's
+// busy and the vector table and all handlers (I2C2, EXTI) live in flash, so every interrupt waits
+// out a page erase (about 20-40 ms) and a page program (a few ms). The SMBus slave holds the clock
+// for that long if a transaction starts meanwhile, and ADV7511 interrupts are answered late.
+
+typedef enum {
+    SMBUS_RAM_READ_PAGE,     // Copy a page into the ram buffer and keep its CRC
+    SMBUS_RAM_APPLY,         // Erase a page, program the ram buffer and keep the CRC read back
+    SMBUS_RAM_SET_FLAG,      // Mark the application invalid while it's being flashed
+    SMBUS_RAM_CLEAR_FLAG,
+} smbus_ram_op;
+
+#define SMBUS_RAM_QUEUE_SIZE 4
+#define SMBUS_RAM_CRC_NOT_READY 0xFF  // Every CRC byte reads this until the page CRC is known
+
+uint8_t smbus_ram_read(const uint8_t command, uint8_t *data, const uint8_t length);
+uint8_t smbus_ram_read_block(const uint8_t command, uint8_t *data, const uint8_t length);
+// CRC1 to CRC4, most significant byte first, SMBUS_RAM_CRC_NOT_READY while jobs are queued
+uint8_t smbus_ram_read_crc(const uint8_t command, uint8_t *data, const uint8_t length);
+// Status byte, then the CRC of the last page read or written most significant byte first
+uint8_t smbus_ram_read_status(const uint8_t command, uint8_t *data, const uint8_t length);
+uint8_t smbus_ram_read_page(const uint8_t command, uint8_t *data, const uint8_t length);
+uint8_t smbus_ram_write(const uint8_t command, uint8_t *data, const uint8_t length);
+uint8_t smbus_ram_write_block(const uint8_t command, uint8_t *data, const uint8_t length);
+uint8_t smbus_ram_write_bank(const uint8_t command, uint8_t *data, const uint8_t length);
+uint8_t smbus_ram_write_index(const uint8_t command, uint8_t *data, const uint8_t length);
+// Ready hook for the ram buffer writes, they're NACKed until the queued jobs are done
+bool smbus_ram_writable();
+
+// Pages are checked by the caller, a full queue fails the request and reports an error
+bool smbus_ram_queue(const smbus_ram_op op, const uint8_t page);
+void smbus_ram_poll();
+bool smbus_ram_busy();
+// Resets from smbus_ram_poll() once the queued jobs are done and the bus is idle
+void smbus_ram_request_reset();
@@ -0,0 +1,462 @@
+#include "smbus_slave.h"
+#include "stm32.h"
+#include "adv7511_i2c.h"
+#include "i2c_timing.h"
+#include "debug.h"
+#include "defines.h"
+#include <stddef.h>
+
+static I2C_HandleTypeDef hi2c2;
+static const smbus_command_table *commands = NULL;
+static uint32_t state = SMBUS_SMS_READY;
+
+static const smbus_command *current = NULL;  // Command of the transaction in progress, NULL before the command byte
+static uint8_t commandByte = 0;
+static uint8_t blockCount = 0;  // Byte count of a block write
+static bool dataReceived = false;  // All data bytes of a write arrived
+static uint8_t *responseData = NULL;  // Prepared from the command byte, sent as is on the read
+static uint8_t responseLength = 0;
+static uint8_t buffer[SMBUS_BLOCK_MAX + 1];  // Block read count + data, write data
+
+static uint16_t recoveries = 0;
+static bool recovery_pending = false;
+static volatile uint32_t last_activity = 0;  // Tick the bus was first seen busy or the slave last made progress
+static bool busy_seen = false;  // BUSY was set at the last poll
+
+#ifdef SMBUS_BENCHMARK
+#define SMBUS_BENCH_COMMANDS 16
+
+// Longest single I2C2 interrupt per command, commands past the table range share the last slot
+static uint16_t bench_max[2][SMBUS_BENCH_COMMANDS];
+static uint16_t bench_max_idle;  // Address matches before a command byte
+#endif
+
+// -------------------- Initialization --------------------
+static bool smbus_slave_start(void)
+{
+    hi2c2.Instance = I2C2;
+    hi2c2.Init.Timing = i2c_timing(i2c_kernel_clock(I2C2), I2C_SPEED_STANDARD);
+    hi2c2.Init.OwnAddress1 = (I2C_SLAVE_ADDR << 1);
+    hi2c2.Init.AddressingMode = I2C_ADDRESSINGMODE_7BIT;
+    hi2c2.Init.DualAddressMode = I2C_DUALADDRESS_DISABLE;
+    hi2c2.Init.OwnAddress2 = 0;
+    hi2c2.Init.OwnAddress2Masks = I2C_OA2_NOMASK;
+    hi2c2.Init.GeneralCallMode = I2C_GENERALCALL_DISABLE;
+    hi2c2.Init.NoStretchMode = I2C_NOSTRETCH_DISABLE; // allow clock stretching
+
+    if(HAL_I2C_Init(&hi2c2) != HAL_OK)
+    {
+        debug_log("SMBUS I2C init failed\n");
+        return false;
+    }
+
+    if (HAL_I2CEx_ConfigAnalogFilter(&hi2c2, I2C_ANALOGFILTER_ENABLE) != HAL_OK)
+    {
+        debug_log("SMBUS I2C config analog filter failed\n");
+        return false;
+    }
+
+    if (HAL_I2CEx_ConfigDigitalFilter(&hi2c2, 0) != HAL_OK)
+    {
+        debug_log("SMBUS I2C config digital filter failed\n");
+        return false;
+    }
+
+    // Start listening for master
+    HAL_I2C_EnableListen_IT(&hi2c2);
+
+    state = SMBUS_SMS_READY;
+    current = NULL;
+    busy_seen = false;
+    last_activity = HAL_GetTick();
+    return true;
+}
+
+void smbus_slave_init(const smbus_command_table *table)
+{
+    commands = table;
+
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+    __HAL_RCC_I2C2_CLK_ENABLE();
+
+    // I2C2 pins: PB10=SCL, PB11=SDA
+    GPIO_InitTypeDef gpio = {0};
+    gpio.Pin = GPIO_PIN_10 | GPIO_PIN_11;
+    gpio.Mode = GPIO_MODE_AF_OD;
+    gpio.Pull = GPIO_PULLUP;
+    gpio.Speed = GPIO_SPEED_FREQ_HIGH;
+    gpio.Alternate = GPIO_AF1_I2C2;
+    HAL_GPIO_Init(GPIOB, &gpio);
+
+    // A failed start is retried from smbus_slave_poll() instead of hanging here
+    recovery_pending = !smbus_slave_start();
+
+    HAL_NVIC_SetPriority(I2C2_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(I2C2_IRQn);
+
+    debug_log("SMBus: I2C Slave 0x%02X ready\r\n", I2C_SLAVE_ADDR);
+}
+
+// Drops the transaction in progress and brings the slave back from a reset peripheral
+static void smbus_slave_recover(void)
+{
+    debug_log("SMBus: recovering\r\n");
+    recoveries++;
+
+    HAL_NVIC_DisableIRQ(I2C2_IRQn);
+    HAL_I2C_DeInit(&hi2c2);
+    __HAL_RCC_I2C2_FORCE_RESET();
+    __HAL_RCC_I2C2_RELEASE_RESET();
+    recovery_pending = !smbus_slave_start();
+    HAL_NVIC_ClearPendingIRQ(I2C2_IRQn);
+    HAL_NVIC_EnableIRQ(I2C2_IRQn);
+}
+
+// An SMBus slave has to give up on a transaction once the clock was held low for 25-35ms.
+// The peripheral has no timeout hardware here, so catch a transaction that stopped making progress.
+void smbus_slave_poll(void)
+{
+    if (recovery_pending)
+    {
+        smbus_slave_recover();
+        return;
+    }
+
+    if (!(hi2c2.Instance->ISR & I2C_ISR_BUSY))
+    {
+        busy_seen = false;
+        return;
+    }
+
+    // After a long sleep the bus may be busy with another device's transfer that only just
+    // started, time it from here rather than from whenever the slave was last addressed
+    if (!busy_seen)
+    {
+        busy_seen = true;
+        last_activity = HAL_GetTick();
+        return;
+    }
+
+    if ((HAL_GetTick() - last_activity) > SMBUS_TIMEOUT_MS)
+    {
+        smbus_slave_recover();
+    }
+}
+
+uint16_t smbus_slave_recoveries(void)
+{
+    return recoveries;
+}
+
+// A transaction in progress needs smbus_slave_poll() every tick to catch a stuck clock
+bool smbus_slave_busy(void)
+{
+    return recovery_pending || (hi2c2.Instance->ISR & I2C_ISR_BUSY);
+}
+
+// Unknown commands read as 0xFF, a written byte is dropped
+static uint8_t smbus_slave_unknown(const uint8_t command, uint8_t *data, const uint8_t length)
+{
+    data[0] = 0xFF;
+    return 1;
+}
+
+static const smbus_command unknown_command = { SMBUS_BYTE, 0, smbus_slave_unknown, NULL };
+
+// Table lookup, the same few instructions for every command byte
+static const smbus_command *smbus_slave_lookup(const uint8_t command)
+{
+    const smbus_command *entry = NULL;
+    if (command & I2C_WRITE_BIT)
+    {
+        const uint8_t index = SMBUS_WRITE_INDEX(command);
+        if (index < commands->write_count)
+        {
+            entry = &commands->writes[index];
+        }
+    }
+    else if (command < commands->read_count)
+    {
+        entry = &commands->reads[command];
+    }
+    return (entry != NULL && entry->handler != NULL) ? entry : &unknown_command;
+}
+
+static void smbus_slave_reset(void)
+{
+    state = SMBUS_SMS_READY;
+    current = NULL;
+    responseLength = 0;
+}
+
+// -------------------- Address Match Callback --------------------
+void HAL_I2C_AddrCallback(I2C_HandleTypeDef *hi2c, uint8_t TransferDirection, uint16_t AddrMatchCode)
+{
+    if(hi2c->Instance != I2C2) return;
+    last_activity = HAL_GetTick();
+
+    if(TransferDirection == I2C_DIRECTION_RECEIVE)
+    {
+        // Master reads (slave transmits)
+        if ((state & SMBUS_SMS_IGNORED) == SMBUS_SMS_IGNORED)
+        {
+            // Best way not to block the line
+            LL_I2C_TransmitData8(hi2c->Instance, 0xFFU);
+            if (LL_I2C_IsActiveFlag_TCR(hi2c->Instance))
+            {
+                LL_I2C_SetTransferSize(hi2c->Instance, 1);
+            }
+            __HAL_I2C_GENERATE_NACK(hi2c);
+            LL_I2C_ClearFlag_ADDR(hi2c->Instance);
+            state &= ~SMBUS_SMS_IGNORED;
+            HAL_I2C_EnableListen_IT(hi2c);
+        }
+        else if (responseLength > 0)
+        {
+            // Response was prepared when the command byte came in, only start sending it
+            state |= SMBUS_SMS_RESPONSE_READY | SMBUS_SMS_TRANSMIT;
+            // Disable SBC, cannot NACK on TX
+            LL_I2C_DisableSlaveByteControl(hi2c->Instance);
+            HAL_I2C_Slave_Seq_Transmit_IT(hi2c, responseData, responseLength, I2C_LAST_FRAME);
+        }
+        else
+        {
+            __HAL_I2C_GENERATE_NACK(hi2c); // NACK if no command
+            LL_I2C_ClearFlag_ADDR(hi2c->Instance);
+            HAL_I2C_EnableListen_IT(hi2c);
+        }
+    }
+    else
+    {
+        // Master writes (slave receives) - new command
+        state &= ~SMBUS_SMS_IGNORED;
+
+        if (state & SMBUS_SMS_READY)
+        {
+            state &= ~SMBUS_SMS_READY;
+            state |= SMBUS_SMS_RECEIVE;
+            current = NULL;
+            responseLength = 0;
+            dataReceived = false;
+            // Enable SBC so we can NACK
+            LL_I2C_EnableSlaveByteControl(hi2c->Instance);
+            HAL_I2C_Slave_Seq_Receive_IT(hi2c, &commandByte, 1, I2C_NEXT_FRAME);
+        }
+    }
+}
+
+// -------------------- Receive Complete Callback --------------------
+void HAL_I2C_SlaveRxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    if(hi2c->Instance != I2C2) return;
+    last_activity = HAL_GetTick();
+
+    if (state & SMBUS_SMS_IGNORED)
+    {
+        __HAL_I2C_GENERATE_NACK(hi2c);
+        if (LL_I2C_IsActiveFlag_TCR(hi2c->Instance))
+        {
+            LL_I2C_SetTransferSize(hi2c->Instance, 1);
+        }
+    }
+    else if (current == NULL)
+    {
+        // Command byte received
+        state &= ~SMBUS_SMS_RECEIVE;
+        current = smbus_slave_lookup(commandByte);
+
+        if ((commandByte & I2C_WRITE_BIT) == 0)
+        {
+            // Read command - prepare response, the read phase only has to start the transfer
+            const uint8_t count = current->handler(commandByte, &buffer[1], current->type == SMBUS_BLOCK ? SMBUS_BLOCK_MAX : 1);
+            if (current->type == SMBUS_BLOCK)
+            {
+                buffer[0] = count;
+                responseData = buffer;
+                responseLength = count + 1;
+            }
+            else
+            {
+                responseData = &buffer[1];
+                responseLength = 1;
+            }
+            // Release the SCL stretch
+            LL_I2C_SetTransferSize(hi2c->Instance, 1);
+        }
+        else if (current->ready != NULL && !current->ready())
+        {
+            // NACK the first byte after the command, nothing gets written
+            state |= SMBUS_SMS_IGNORED;
+            __HAL_I2C_GENERATE_NACK(hi2c);
+            LL_I2C_SetTransferSize(hi2c->Instance, 1);
+        }
+        else if (current->type == SMBUS_BLOCK)
+        {
+            // Block write - receive the byte count first
+            blockCount = 0;
+            state |= SMBUS_SMS_RECEIVE | SMBUS_SMS_PROCESSING;
+            HAL_I2C_Slave_Seq_Receive_IT(hi2c, &blockCount, 1, I2C_NEXT_FRAME);
+        }
+        else
+        {
+            // Write command - receive data byte
+            blockCount = 1;
+            state |= SMBUS_SMS_RECEIVE;
+            HAL_I2C_Slave_Seq_Receive_IT(hi2c, buffer, 1, I2C_LAST_FRAME);
+        }
+    }
+    else if (state & SMBUS_SMS_PROCESSING)
+    {
+        // Block Write, got the size
+        state &= ~(SMBUS_SMS_PROCESSING | SMBUS_SMS_RECEIVE);
+        if (blockCount == 0 || blockCount > SMBUS_BLOCK_MAX || (current->length != 0 && blockCount != current->length))
+        {
+            // NACK the first data byte, nothing gets written
+            state |= SMBUS_SMS_IGNORED;
+            __HAL_I2C_GENERATE_NACK(hi2c);
+            LL_I2C_SetTransferSize(hi2c->Instance, 1);
+        }
+        else
+        {
+            state |= SMBUS_SMS_RECEIVE;
+            // Disable SBC, the count is known so every data byte gets ACKed
+            LL_I2C_DisableSlaveByteControl(hi2c->Instance);
+            HAL_I2C_Slave_Seq_Receive_IT(hi2c, buffer, blockCount, I2C_LAST_FRAME);
+        }
+    }
+    else
+    {
+        state &= ~SMBUS_SMS_RECEIVE;
+        dataReceived = true;
+    }
+}
+
+// -------------------- Transmit Complete Callback --------------------
+void HAL_I2C_SlaveTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    if(hi2c->Instance != I2C2) return;
+    last_activity = HAL_GetTick();
+    state &= ~SMBUS_SMS_TRANSMIT;
+}
+
+// -------------------- Listen Complete Callback --------------------
+void HAL_I2C_ListenCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    if(hi2c->Instance != I2C2) return;
+    last_activity = HAL_GetTick();
+
+    // A write only counts once every data byte arrived
+    if (current != NULL && (commandByte & I2C_WRITE_BIT) && dataReceived && hi2c->XferCount == 0)
+    {
+        current->handler(commandByte, buffer, blockCount);
+    }
+
+    // Do it all again
+    smbus_slave_reset();
+    HAL_I2C_EnableListen_IT(hi2c);
+}
+
+// -------------------- Error Callback --------------------
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+{
+    if(hi2c->Instance == I2C1)
+    {
+        adv7511_i2c_error(hi2c);
+        return;
+    }
+    if(hi2c->Instance != I2C2) return;
+
+    uint32_t err = hi2c->ErrorCode;
+
+    if (err & (HAL_I2C_ERROR_BERR | HAL_I2C_ERROR_TIMEOUT))
+    {
+        // Critical error - reset the stack
+        if(state & (SMBUS_SMS_TRANSMIT | SMBUS_SMS_RECEIVE | SMBUS_SMS_PROCESSING))
+        {
+            __HAL_I2C_DISABLE(hi2c);
+            while (LL_I2C_IsEnabled(hi2c->Instance)) {}
+            __HAL_I2C_ENABLE(hi2c);
+            if(hi2c->State != HAL_I2C_STATE_READY)
+            {
+                HAL_I2C_DeInit(hi2c);
+                HAL_I2C_Init(hi2c);
+                HAL_I2C_EnableListen_IT(hi2c);
+                recoveries++;
+            }
+        }
+        smbus_slave_reset();
+    }
+    else if (err & HAL_I2C_ERROR_AF)
+    {
+        // NACK - expected at end of read, handle gracefully
+        hi2c->PreviousState = hi2c->State;
+        hi2c->State = HAL_I2C_STATE_READY;
+        __HAL_UNLOCK(hi2c);
+        smbus_slave_reset();
+        HAL_I2C_EnableListen_IT(hi2c);
+    }
+    else if(err != HAL_I2C_ERROR_NONE)
+    {
+        // Arbitration lost and the rest
+        smbus_slave_reset();
+        HAL_I2C_EnableListen_IT(hi2c);
+    }
+}
+
+// -------------------- Benchmark --------------------
+#ifdef SMBUS_BENCHMARK
+// SysTick counts down from LOAD, one interrupt is far shorter than a tick
+static void bench_record(const uint32_t start)
+{
+    const uint32_t end = SysTick->VAL;
+    const uint32_t cycles = start >= end ? start - end : start + (SysTick->LOAD + 1) - end;
+    const uint16_t clamped = cycles > 0xFFFF ? 0xFFFF : (uint16_t)cycles;
+
+    uint16_t *slot = &bench_max_idle;
+    if (current != NULL)
+    {
+        const uint8_t index = commandByte & ~I2C_WRITE_BIT;
+        slot = &bench_max[(commandByte & I2C_WRITE_BIT) ? 1 : 0][index < SMBUS_BENCH_COMMANDS ? index : SMBUS_BENCH_COMMANDS - 1];
+    }
+    if (clamped > *slot)
+    {
+        *slot = clamped;
+    }
+}
+
+void smbus_slave_benchmark_report()
+{
+    debug_log("SMBus ISR max %u cycles before a command\r\n", (unsigned int)bench_max_idle);
+    for (uint8_t write = 0; write < 2; write++)
+    {
+        for (uint8_t i = 0; i < SMBUS_BENCH_COMMANDS; i++)
+        {
+            if (bench_max[write][i] != 0)
+            {
+                debug_log("SMBus ISR command %u: max %u cycles\r\n", (unsigned int)(write ? (i | I2C_WRITE_BIT) : i), (unsigned int)bench_max[write][i]);
+            }
+        }
+    }
+}
+#endif
+
+// -------------------- IRQ Handler --------------------
+void I2C2_IRQHandler(void)
+{
+#ifdef SMBUS_BENCHMARK
+    const uint32_t start = SysTick->VAL;
+#endif
+
+    if (hi2c2.Instance->ISR & (I2C_FLAG_BERR | I2C_FLAG_ARLO | I2C_FLAG_OVR | I2C_FLAG_TIMEOUT | I2C_FLAG_ALERT | I2C_FLAG_PECERR))
+    {
+        HAL_I2C_ER_IRQHandler(&hi2c2);
+    }
+    else
+    {
+        HAL_I2C_EV_IRQHandler(&hi2c2);
+    }
+
+#ifdef SMBUS_BENCHMARK
+    bench_record(start);
+#endif
+}
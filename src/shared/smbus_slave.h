@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// SMBus slave on I2C2, shared by the bootloader and the application. Each image hands in a table
+// of the commands it knows, the engine looks them up by command byte and runs the handler.
+
+#define SMBUS_BYTE  0  // One data byte follows the command
+#define SMBUS_BLOCK 1  // A byte count and up to SMBUS_BLOCK_MAX bytes follow the command
+
+// Reads fill data and return the byte count, a byte read returns 1.
+// Writes get the received bytes in data and length, the return value is unused.
+// Handlers run in the I2C2 interrupt while the clock is held, keep them short.
+typedef uint8_t (*smbus_handler)(const uint8_t command, uint8_t *data, const uint8_t length);
+// Asked when a write's command byte arrives, false NACKs the data so the master retries later
+typedef bool (*smbus_ready)(void);
+
+typedef struct {
+    uint8_t type;           // SMBUS_BYTE or SMBUS_BLOCK
+    uint8_t length;         // Block writes only, byte count the master has to send, 0 takes any
+    smbus_handler handler;
+    smbus_ready ready;      // Writes only, NULL takes the data at any time
+} smbus_command;
+
+// Writes sit in their table at the command without I2C_WRITE_BIT
+#define SMBUS_WRITE_INDEX(command) ((command) & 0x7F)
+
+// Reads are indexed by command, writes by SMBUS_WRITE_INDEX(command).
+// Gaps in the tables are entries with a NULL handler.
+typedef struct {
+    const smbus_command *reads;
+    uint8_t read_count;
+    const smbus_command *writes;
+    uint8_t write_count;
+} smbus_command_table;
+
+void smbus_slave_init(const smbus_command_table *table);
+void smbus_slave_poll();
+uint16_t smbus_slave_recoveries();
+bool smbus_slave_busy();
+
+#ifdef SMBUS_BENCHMARK
+void smbus_slave_benchmark_report();
+#endif
@@ -2,6 +2,7 @@
 
 #include "xbox_video_standalone.h"
 #include "adv7511_minimal.h"
+#include "adv7511_regs.h"
 #include "adv7511_xbox.h"
 #include "debug.h"
 
@@ -30,9 +31,10 @@ const video_setting_vic video_settings_xcalibur[] = {
 };
 
 void stand_alone_loop(adv7511 * encoder, const xbox_encoder xb_encoder) {
-    if ((adv7511_read_register(0x3e) >> 2) != (encoder->vic & 0x0F)) {
+    // encoder->status is refreshed by the caller with adv7511_read_status()
+    if (encoder->status.vic_detected != (encoder->vic & 0x0F)) {
         // Set MSB to 1. This indicates a recent change.
-        encoder->vic = ADV7511_VIC_CHANGED | adv7511_read_register(0x3e) >> 2;
+        encoder->vic = ADV7511_VIC_CHANGED | encoder->status.vic_detected;
         debug_log("Detected VIC#: 0x%02x\r\n", encoder->vic & ADV7511_VIC_CHANGED_CLEAR);
     }
 
@@ -84,37 +86,45 @@ void set_video_mode_vic(const xbox_encoder xb_encoder, const uint8_t mode, const
 
     debug_log("Set %d mode, widescreen %s, interlaced %s\r\n", mode, widescreen ? "true" : "false", interlaced ? "true" : "false");
 
-    // Make sure CSC is off
-    adv7511_update_register(0x18, 0b10000000, 0b00000000);
+    // Stage everything and switch over in one go at the next VSYNC
+    adv7511_begin_update();
 
-    adv7511_write_register(0x35, (uint8_t)(vs->delay_hs >> 2));
-    adv7511_write_register(0x36, ((0b00111111 & (uint8_t)vs->delay_vs)) | (0b11000000 & (uint8_t)(vs->delay_hs << 6)));
-    adv7511_update_register(0x37, 0b00011111, (uint8_t)(vs->active_w >> 7)); // 0x37 is shared with interlaced
-    adv7511_write_register(0x38, (uint8_t)(vs->active_w << 1));
-    adv7511_write_register(0x39, (uint8_t)(vs->active_h >> 4));
-    adv7511_write_register(0x3A, (uint8_t)(vs->active_h << 4));
+    // Make sure CSC is off
+    adv7511_set_csc_enable(0);
+
+    const uint8_t de_timing[] = {
+        (uint8_t)(vs->delay_hs >> 2),                                                         // 0x35
+        ((0b00111111 & (uint8_t)vs->delay_vs)) | (0b11000000 & (uint8_t)(vs->delay_hs << 6)), // 0x36
+        (adv7511_read_register(0x37) & adv7511_mask_interlace_offset()) | (0b00011111 & (uint8_t)(vs->active_w >> 7)), // 0x37 is shared with interlaced
+        (uint8_t)(vs->active_w << 1),                                                          // 0x38
+        (uint8_t)(vs->active_h >> 4),                                                          // 0x39
+        (uint8_t)(vs->active_h << 4)                                                           // 0x3A
+    };
+    adv7511_write_registers(0x35, de_timing, sizeof(de_timing));
 
     update_avi_infoframe(widescreen);
 
     // For VIC mode
     if (interlaced) {
         // Interlace Offset For DE Generation
-        adv7511_update_register(0x37, 0b11100000, 0b00000000);
+        adv7511_set_interlace_offset(0);
         // Offset for Sync Adjustment Vsync Placement
         adv7511_write_register(0xDC, 0b00000000);
         // Enable settings
-        adv7511_update_register(0x41, 0b00000010, 0b00000010);
+        adv7511_set_sync_adjust_enable(1);
     } else {
         // Disable manual sync
-        adv7511_update_register(0x41, 0b00000010, 0b00000000);
+        adv7511_set_sync_adjust_enable(0);
     }
 
     // Fixes jumping for 1080i, somehow doing this in the init sequence doesnt stick or gets reset
-    adv7511_update_register(0xD0, 0b00000010, 0b00000010);
+    adv7511_set_timing_gen_sequence(1);
 
     // Set the vic from the table
     adv7511_write_register(0x3C, vs->vic);
 
+    adv7511_commit_update();
+
     debug_log("Actual Pixel Repetition : 0x%02x\r\n", (adv7511_read_register(0x3D) & 0xC0) >> 6);
     debug_log("Actual VIC Sent : 0x%02x\r\n", adv7511_read_register(0x3D) & 0x1F);
 }